@@ -0,0 +1,545 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+// Echo load generator: runs an in-process NetFramedEventHandler echo server on every selected event manager,
+// drives it from N client connections and reports throughput and latency percentiles, optionally appended to a CSV file.
+//
+//   LENetLoadGenerator [--backend all|poll|select|epoll|epoll-et|io-uring|iocp|external] [--connections 64] [--size 64]
+//                      [--open <msgs/s per connection>] [--pipeline 1] [--duration 5] [--warmup 1] [--client-threads 1]
+//                      [--server-threads 0] [--wait block|spin|busy|adaptive] [--spin-us 50] [--busy-poll-us 0]
+//                      [--host 127.0.0.1] [--port 3100] [--csv results.csv] [--label <text>] [--log-level 3]
+//
+// Closed loop (default) keeps --pipeline messages in flight per connection. Open loop sends on a fixed schedule
+// regardless of replies, latency is measured from the scheduled send time so a stalled server can't hide its queueing.
+// --wait selects the server's NetWaitStrategy, the time its event loop spent spinning and blocked is reported with the results.
+// --backend external drives an already running framed echo server (e.g. `LENet -s --framed`) at --host:--port.
+// Build with optimizations and a LENET_LOG_LEVEL of 2 or more, trace logging dominates every other cost.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "NetServer.hpp"
+#include "NetPollEventManager.hpp"
+#include "NetSelectEventManager.hpp"
+#include "NetEpollEventManager.hpp"
+#include "NetIOCPEventManager.hpp"
+#include "NetIoUringEventManager.hpp"
+#include "NetFramedEventHandler.hpp"
+#include "Protocols/NetProtocolFramedTCP.hpp"
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	#pragma comment(lib, "Ws2_32.lib")
+#endif
+
+namespace LimeEngine::Net::Benchmark
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum class LoadMode
+	{
+		Closed,
+		Open
+	};
+
+	struct LoadOptions
+	{
+		std::string host = "127.0.0.1";
+		uint16_t port = 3100;
+		size_t connections = 64;
+		// Payload size, the first 8 bytes carry the send timestamp
+		size_t messageSize = 64;
+		LoadMode mode = LoadMode::Closed;
+		// Closed loop: messages in flight per connection
+		uint32_t pipeline = 1;
+		// Open loop: messages per second per connection
+		double rate = 1000.0;
+		std::chrono::milliseconds warmup{ 1000 };
+		std::chrono::milliseconds duration{ 5000 };
+		size_t clientThreads = 1;
+		// 0 runs the server loop on one thread, otherwise the server is sharded over that many workers
+		size_t serverThreads = 0;
+		NetWaitOptions wait;
+		std::string csvPath;
+		std::string label;
+	};
+
+	struct LoadResult
+	{
+		void Merge(LoadResult&& other)
+		{
+			messages += other.messages;
+			bytes += other.bytes;
+			errors += other.errors;
+			latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+		}
+
+		std::string backend;
+		// Echoes received during the measured window
+		uint64_t messages = 0;
+		uint64_t bytes = 0;
+		// Connections that failed or were closed by the server
+		uint64_t errors = 0;
+		double seconds = 0.0;
+		// Time the server's event loop spent polling and blocked, over warmup and measurement
+		double spinSeconds = 0.0;
+		double blockedSeconds = 0.0;
+		// Nanoseconds, only for messages sent and echoed inside the measured window
+		std::vector<uint64_t> latencies;
+	};
+
+	uint64_t ToNanoseconds(Clock::time_point time) noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+	}
+
+	const char* GetWaitModeName(NetWaitMode mode) noexcept
+	{
+		switch (mode)
+		{
+			case NetWaitMode::SpinThenBlock: return "spin";
+			case NetWaitMode::BusyPoll: return "busy";
+			case NetWaitMode::Adaptive: return "adaptive";
+			default: return "block";
+		}
+	}
+
+	double Percentile(const std::vector<uint64_t>& sorted, double percentile) noexcept
+	{
+		if (sorted.empty()) return 0.0;
+		size_t rank = static_cast<size_t>(std::ceil(percentile * static_cast<double>(sorted.size())));
+		return static_cast<double>(sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1]);
+	}
+
+	class LoadConnection
+	{
+	public:
+		explicit LoadConnection(NetSocketIPv4Address address) : socket(NetAddressType::IPv4)
+		{
+			connected = socket.Connect(address);
+			if (!connected) return;
+			socket.SetNoDelay();
+			socket.SetNonblockingMode();
+		}
+
+		void Enqueue(const std::string& frameTemplate, uint64_t timestamp)
+		{
+			size_t offset = sendBuffer.size();
+			sendBuffer.append(frameTemplate);
+			memcpy(sendBuffer.data() + offset + NetProtocolFramedTCP::headerSize, &timestamp, sizeof(timestamp));
+			++inFlight;
+		}
+
+		// Returns false if the connection is lost
+		bool Flush()
+		{
+			while (sendOffset < sendBuffer.size())
+			{
+				int size = static_cast<int>(std::min<size_t>(sendBuffer.size() - sendOffset, std::numeric_limits<int>::max()));
+				int bytesSent;
+				if (!socket.Send(sendBuffer.data() + sendOffset, size, bytesSent)) return bytesSent == -1;
+				sendOffset += bytesSent;
+			}
+			sendBuffer.clear();
+			sendOffset = 0;
+			return true;
+		}
+
+		// Calls onEcho(timestamp, receiveTime, payloadSize) for every echoed message, returns false if the connection is lost
+		template <typename TOnEcho>
+		bool Receive(std::vector<char>& buffer, TOnEcho&& onEcho)
+		{
+			while (true)
+			{
+				int bytesReceived;
+				if (!socket.Receive(buffer.data(), static_cast<int>(buffer.size()), bytesReceived)) return bytesReceived == -1;
+
+				uint64_t now = ToNanoseconds(Clock::now());
+				bool valid = decoder.Feed(buffer.data(), static_cast<size_t>(bytesReceived), [this, now, &onEcho](std::string&& message) {
+					uint64_t timestamp = 0;
+					if (message.size() >= sizeof(timestamp)) memcpy(&timestamp, message.data(), sizeof(timestamp));
+					if (inFlight != 0) --inFlight;
+					onEcho(timestamp, now, message.size());
+				});
+				if (!valid) return false;
+			}
+		}
+
+		bool HasPendingSend() const noexcept
+		{
+			return sendOffset < sendBuffer.size();
+		}
+
+	public:
+		NetSocket socket;
+		NetFrameDecoder decoder;
+		std::string sendBuffer;
+		size_t sendOffset = 0;
+		uint32_t inFlight = 0;
+		Clock::time_point nextSend;
+		bool connected = false;
+		bool failed = false;
+	};
+
+	class EchoHandler : public NetConnectionHandlerBase
+	{
+	public:
+		void OnMessage(NetConnection& connection, const NetReceivedMessage& receivedMessage)
+		{
+			connection.Send(receivedMessage.msg);
+		}
+	};
+
+	LoadResult RunClients(const LoadOptions& options, NetSocketIPv4Address address, size_t connectionCount, size_t firstConnection, Clock::time_point start)
+	{
+		LoadResult result;
+
+		std::string frameTemplate = NetProtocolFramedTCP::Frame(std::string(std::max(options.messageSize, sizeof(uint64_t)), 'x'));
+		auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(options.rate, 1e-3)));
+		const uint64_t measureStart = ToNanoseconds(start + options.warmup);
+		const Clock::time_point end = start + options.warmup + options.duration;
+		const uint64_t measureEnd = ToNanoseconds(end);
+
+		std::vector<LoadConnection> connections;
+		connections.reserve(connectionCount);
+		for (size_t i = 0; i < connectionCount; ++i)
+		{
+			auto& connection = connections.emplace_back(address);
+			if (!connection.connected)
+			{
+				connection.failed = true;
+				++result.errors;
+			}
+			// Spread open-loop sends over the interval instead of sending in bursts
+			size_t globalIndex = firstConnection + i;
+			connection.nextSend = start + interval * globalIndex / std::max<size_t>(options.connections, 1);
+		}
+
+		std::vector<NativePollFD> pollFDs(connections.size());
+		std::vector<char> receiveBuffer(64 * 1024);
+		auto onEcho = [&](uint64_t timestamp, uint64_t now, size_t payloadSize) {
+			if (now < measureStart || now >= measureEnd) return;
+			++result.messages;
+			result.bytes += payloadSize;
+			if (timestamp >= measureStart) result.latencies.push_back(now - timestamp);
+		};
+		auto fail = [&result](LoadConnection& connection) {
+			connection.failed = true;
+			connection.socket.Close();
+			++result.errors;
+		};
+
+		while (true)
+		{
+			Clock::time_point now = Clock::now();
+			if (now >= end) break;
+
+			Clock::time_point nextDue = end;
+			for (size_t i = 0; i < connections.size(); ++i)
+			{
+				auto& connection = connections[i];
+				auto& pollFD = pollFDs[i];
+				pollFD.fd = connection.socket.GetNativeSocket();
+				pollFD.events = 0;
+				pollFD.revents = 0;
+				if (connection.failed) continue;
+
+				if (options.mode == LoadMode::Open)
+				{
+					while (connection.nextSend <= now)
+					{
+						connection.Enqueue(frameTemplate, ToNanoseconds(connection.nextSend));
+						connection.nextSend += interval;
+					}
+					nextDue = std::min(nextDue, connection.nextSend);
+				}
+				else
+				{
+					while (connection.inFlight < options.pipeline)
+					{
+						connection.Enqueue(frameTemplate, ToNanoseconds(now));
+					}
+				}
+				if (!connection.Flush())
+				{
+					fail(connection);
+					continue;
+				}
+
+				pollFD.events = POLLRDNORM;
+				if (connection.HasPendingSend()) pollFD.events |= POLLWRNORM;
+			}
+
+			// Closed loop only needs to wake up for replies, open loop also for the next scheduled send
+			auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextDue - Clock::now());
+			uint32_t timeout = static_cast<uint32_t>(std::clamp<int64_t>(wait.count(), 0, 100));
+			if (NativePoll(pollFDs.data(), pollFDs.size(), timeout) <= 0) continue;
+
+			for (size_t i = 0; i < connections.size(); ++i)
+			{
+				auto& connection = connections[i];
+				if (connection.failed || pollFDs[i].revents == 0) continue;
+				if (!connection.Receive(receiveBuffer, onEcho)) fail(connection);
+			}
+		}
+
+		result.seconds = std::chrono::duration<double>(options.duration).count();
+		return result;
+	}
+
+	LoadResult RunLoad(const LoadOptions& options, NetSocketIPv4Address address)
+	{
+		size_t threadCount = std::clamp<size_t>(options.clientThreads, 1, std::max<size_t>(options.connections, 1));
+		std::vector<LoadResult> results(threadCount);
+		std::vector<std::thread> threads;
+		Clock::time_point start = Clock::now();
+
+		size_t firstConnection = 0;
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			size_t connectionCount = options.connections / threadCount + (i < options.connections % threadCount ? 1 : 0);
+			threads.emplace_back([&options, address, connectionCount, firstConnection, start, &result = results[i]]() {
+				result = RunClients(options, address, connectionCount, firstConnection, start);
+			});
+			firstConnection += connectionCount;
+		}
+
+		LoadResult total;
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			threads[i].join();
+			total.Merge(std::move(results[i]));
+		}
+		total.seconds = std::chrono::duration<double>(options.duration).count();
+		return total;
+	}
+
+	template <typename TNetEventManager>
+	LoadResult RunBackend(const char* backend, const LoadOptions& options, uint16_t port)
+	{
+		NetServer<TNetEventManager, EchoHandler> server(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), port), EchoHandler());
+		server.SetDispatchMode(NetDispatchMode::Inline);
+		server.SetWaitStrategy(options.wait);
+
+		for (size_t i = 1; i < options.serverThreads; ++i)
+		{
+			server.AddEventHandler();
+		}
+		if (options.serverThreads != 0) server.StartSharded();
+
+		std::atomic<bool> running = true;
+		std::thread serverThread([&server, &running, backend, threaded = options.serverThreads != 0]() {
+			NetMetrics::SetThreadName(std::format("{} server", backend));
+			while (running.load(std::memory_order_relaxed))
+			{
+				if (threaded) { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+				else
+				{
+					server.Accept();
+					server.HandleNetEvents();
+				}
+			}
+		});
+
+		NetMetricsSnapshot before = NetMetrics::Snapshot();
+		LoadResult result = RunLoad(options, NetSocketIPv4Address(NetIPv4Address(options.host), port));
+		result.backend = backend;
+
+		running.store(false, std::memory_order_relaxed);
+		serverThread.join();
+		NetMetricsSnapshot after = NetMetrics::Snapshot();
+		result.spinSeconds = static_cast<double>(after.Get(NetCounter::SpinNanoseconds) - before.Get(NetCounter::SpinNanoseconds)) / 1e9;
+		result.blockedSeconds = static_cast<double>(after.Get(NetCounter::BlockedNanoseconds) - before.Get(NetCounter::BlockedNanoseconds)) / 1e9;
+		server.DisconnectAll();
+		return result;
+	}
+
+	std::vector<LoadResult> RunBackends(const std::string& backend, const LoadOptions& options)
+	{
+		std::vector<LoadResult> results;
+		// Every backend gets its own port, so the previous one's sockets in TIME_WAIT don't get in the way
+		uint16_t port = options.port;
+		auto selected = [&backend](const char* name) {
+			return backend == "all" || backend == name;
+		};
+
+		if (backend == "external")
+		{
+			LoadResult result = RunLoad(options, NetSocketIPv4Address(NetIPv4Address(options.host), options.port));
+			result.backend = backend;
+			results.push_back(std::move(result));
+			return results;
+		}
+
+		if (selected("poll")) results.push_back(RunBackend<NetPollEventManager<NetProtocolFramedTCP, NetFramedEventHandler>>("poll", options, port++));
+		if (selected("select")) results.push_back(RunBackend<NetSelectEventManager<NetProtocolFramedTCP, NetFramedEventHandler>>("select", options, port++));
+#ifdef LE_BUILD_PLATFORM_LINUX
+		if (selected("epoll")) results.push_back(RunBackend<NetEpollEventManager<NetProtocolFramedTCP, NetFramedEventHandler>>("epoll", options, port++));
+		if (selected("epoll-et"))
+		{
+			results.push_back(
+				RunBackend<NetEpollEventManager<NetProtocolFramedTCP, NetFramedEventHandler, NetEpollTrigger::Edge>>("epoll-et", options, port++));
+		}
+		if (selected("io-uring")) results.push_back(RunBackend<NetIoUringEventManager<NetProtocolFramedTCP, NetFramedEventHandler>>("io-uring", options, port++));
+#endif
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		if (selected("iocp")) results.push_back(RunBackend<NetIOCPEventManager<NetProtocolFramedTCP, NetFramedEventHandler>>("iocp", options, port++));
+#endif
+		return results;
+	}
+
+	void Report(LoadResult& result, const LoadOptions& options)
+	{
+		std::sort(result.latencies.begin(), result.latencies.end());
+		double throughput = result.seconds > 0.0 ? static_cast<double>(result.messages) / result.seconds : 0.0;
+		double bandwidth = result.seconds > 0.0 ? static_cast<double>(result.bytes) / result.seconds / (1024.0 * 1024.0) : 0.0;
+		double p50 = Percentile(result.latencies, 0.50) / 1000.0;
+		double p99 = Percentile(result.latencies, 0.99) / 1000.0;
+		double p999 = Percentile(result.latencies, 0.999) / 1000.0;
+		double max = result.latencies.empty() ? 0.0 : static_cast<double>(result.latencies.back()) / 1000.0;
+
+		std::cout << std::format("{:<9} {:>12.0f} msg/s {:>9.2f} MiB/s  p50 {:>9.1f}us  p99 {:>9.1f}us  p999 {:>9.1f}us  max {:>9.1f}us  errors {}  spin {:.2f}s  blocked {:.2f}s",
+								 result.backend,
+								 throughput,
+								 bandwidth,
+								 p50,
+								 p99,
+								 p999,
+								 max,
+								 result.errors,
+								 result.spinSeconds,
+								 result.blockedSeconds)
+				  << std::endl;
+
+		if (options.csvPath.empty()) return;
+
+		bool writeHeader = !std::filesystem::exists(options.csvPath) || std::filesystem::file_size(options.csvPath) == 0;
+		std::ofstream csv(options.csvPath, std::ios::app);
+		if (!csv)
+		{
+			std::cerr << "Can't open " << options.csvPath << std::endl;
+			return;
+		}
+		if (writeHeader)
+		{
+			csv << "label,backend,mode,connections,message_size,pipeline,rate,client_threads,server_threads,seconds,messages,msgs_per_sec,mib_per_sec,p50_us,p99_us,"
+				   "p999_us,max_us,errors,wait,spin_s,blocked_s\n";
+		}
+		csv << std::format("{},{},{},{},{},{},{},{},{},{:.3f},{},{:.1f},{:.3f},{:.2f},{:.2f},{:.2f},{:.2f},{},{},{:.3f},{:.3f}\n",
+						   options.label,
+						   result.backend,
+						   options.mode == LoadMode::Open ? "open" : "closed",
+						   options.connections,
+						   options.messageSize,
+						   options.mode == LoadMode::Open ? 0u : options.pipeline,
+						   options.mode == LoadMode::Open ? options.rate : 0.0,
+						   options.clientThreads,
+						   options.serverThreads,
+						   result.seconds,
+						   result.messages,
+						   throughput,
+						   bandwidth,
+						   p50,
+						   p99,
+						   p999,
+						   max,
+						   result.errors,
+						   GetWaitModeName(options.wait.mode),
+						   result.spinSeconds,
+						   result.blockedSeconds);
+	}
+}
+
+char* getCmdOption(char** begin, char** end, const std::string& option)
+{
+	char** itr = std::find(begin, end, option);
+	if (itr != end && ++itr != end) { return *itr; }
+	return nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+	using namespace LimeEngine::Net;
+	using namespace LimeEngine::Net::Benchmark;
+
+	LoadOptions options;
+	std::string backend = "all";
+	NetLogger::SetLevel(NetLogLevel::Error);
+
+	if (char* value = getCmdOption(argv, argv + argc, "--backend"); value != nullptr) { backend = value; }
+	if (char* value = getCmdOption(argv, argv + argc, "--host"); value != nullptr) { options.host = value; }
+	if (char* value = getCmdOption(argv, argv + argc, "--port"); value != nullptr) { options.port = static_cast<uint16_t>(std::stoi(value)); }
+	if (char* value = getCmdOption(argv, argv + argc, "--connections"); value != nullptr) { options.connections = std::max(std::stoul(value), 1ul); }
+	if (char* value = getCmdOption(argv, argv + argc, "--size"); value != nullptr) { options.messageSize = std::stoul(value); }
+	if (char* value = getCmdOption(argv, argv + argc, "--pipeline"); value != nullptr) { options.pipeline = std::max(static_cast<uint32_t>(std::stoul(value)), 1u); }
+	if (char* value = getCmdOption(argv, argv + argc, "--open"); value != nullptr)
+	{
+		options.mode = LoadMode::Open;
+		options.rate = std::stod(value);
+	}
+	if (char* value = getCmdOption(argv, argv + argc, "--duration"); value != nullptr)
+	{
+		options.duration = std::chrono::milliseconds(static_cast<int64_t>(std::stod(value) * 1000.0));
+	}
+	if (char* value = getCmdOption(argv, argv + argc, "--warmup"); value != nullptr)
+	{
+		options.warmup = std::chrono::milliseconds(static_cast<int64_t>(std::stod(value) * 1000.0));
+	}
+	if (char* value = getCmdOption(argv, argv + argc, "--client-threads"); value != nullptr) { options.clientThreads = std::max(std::stoul(value), 1ul); }
+	if (char* value = getCmdOption(argv, argv + argc, "--server-threads"); value != nullptr) { options.serverThreads = std::stoul(value); }
+	if (char* value = getCmdOption(argv, argv + argc, "--wait"); value != nullptr)
+	{
+		std::string_view wait = value;
+		if (wait == "spin") { options.wait.mode = NetWaitMode::SpinThenBlock; }
+		else if (wait == "busy") { options.wait.mode = NetWaitMode::BusyPoll; }
+		else if (wait == "adaptive") { options.wait.mode = NetWaitMode::Adaptive; }
+		else { options.wait.mode = NetWaitMode::Block; }
+	}
+	if (char* value = getCmdOption(argv, argv + argc, "--spin-us"); value != nullptr) { options.wait.spinTime = std::chrono::microseconds(std::stoul(value)); }
+	if (char* value = getCmdOption(argv, argv + argc, "--busy-poll-us"); value != nullptr) { options.wait.socketBusyPoll = static_cast<uint32_t>(std::stoul(value)); }
+	if (char* value = getCmdOption(argv, argv + argc, "--csv"); value != nullptr) { options.csvPath = value; }
+	if (char* value = getCmdOption(argv, argv + argc, "--label"); value != nullptr) { options.label = value; }
+	if (char* value = getCmdOption(argv, argv + argc, "--log-level"); value != nullptr)
+	{
+		NetLogger::SetLevel(static_cast<NetLogLevel>(std::clamp(std::stoi(value), 0, 4)));
+	}
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	WSADATA wsData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsData) != NO_ERROR)
+	{
+		std::cerr << "WSAStartup failed" << std::endl;
+		return 1;
+	}
+#endif
+
+	std::cout << std::format("{} loop, {} connections, {} byte messages, {}, {}s after {}s warmup, {} wait",
+							 options.mode == LoadMode::Open ? "Open" : "Closed",
+							 options.connections,
+							 options.messageSize,
+							 options.mode == LoadMode::Open ? std::format("{} msg/s per connection", options.rate) : std::format("pipeline {}", options.pipeline),
+							 std::chrono::duration<double>(options.duration).count(),
+							 std::chrono::duration<double>(options.warmup).count(),
+							 GetWaitModeName(options.wait.mode))
+			  << std::endl;
+
+	auto results = RunBackends(backend, options);
+	if (results.empty()) std::cerr << "Unknown or unavailable backend: " << backend << std::endl;
+	for (auto& result : results)
+	{
+		Report(result, options);
+	}
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	WSACleanup();
+#endif
+	return results.empty() ? 1 : 0;
+}
@@ -0,0 +1,523 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+// Microbenchmarks of the receive hot path: buffer pools, buffer chains, ConcatBuffers and message assembly in the event handlers.
+//
+//   LENetMicroBenchmarks [--filter <substring>] [--min-time 200] [--repetitions 3] [--csv results.csv] [--label <text>]
+//
+// Every benchmark is calibrated to run for at least --min-time milliseconds and the fastest repetition is reported.
+// allocs/op counts global operator new calls on the benchmark threads, slabs mapped by SlabAllocator are not included.
+// bytes copied/op is the payload the benchmarked code copies in user space for one op, derived from the synthetic workload;
+// the simulated receives that fill the buffers are timed but not counted.
+// Build with optimizations and a LENET_LOG_LEVEL of 2 or more, otherwise the trace log checks are measured as well.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BufferPool.hpp"
+#include "ConcurrentBufferPool.hpp"
+#include "NetConnectionHandler.hpp"
+#include "NetContext.hpp"
+#include "NetEventHandler.hpp"
+#include "NetFramedEventHandler.hpp"
+#include "Protocols/NetProtocolFramedTCP.hpp"
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	#include <intrin.h>
+	#pragma comment(lib, "Ws2_32.lib")
+#endif
+
+namespace
+{
+	thread_local uint64_t allocationCount = 0;
+
+	void* Allocate(std::size_t size)
+	{
+		++allocationCount;
+		if (void* memory = std::malloc(size != 0 ? size : 1)) return memory;
+		throw std::bad_alloc();
+	}
+
+	void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		++allocationCount;
+		size_t align = static_cast<size_t>(alignment);
+#ifdef _MSC_VER
+		void* memory = _aligned_malloc(size != 0 ? size : 1, align);
+#else
+		void* memory = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+#endif
+		if (memory == nullptr) throw std::bad_alloc();
+		return memory;
+	}
+
+	void FreeAligned(void* memory) noexcept
+	{
+#ifdef _MSC_VER
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return Allocate(size);
+}
+void* operator new[](std::size_t size)
+{
+	return Allocate(size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return AllocateAligned(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return AllocateAligned(size, alignment);
+}
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+namespace LimeEngine::Net::Benchmark
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Keeps the compiler from dropping a computation whose result is otherwise unused
+	template <typename T>
+	void DoNotOptimize(const T& value)
+	{
+#ifdef _MSC_VER
+		static const void* volatile sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r"(&value) : "memory");
+#endif
+	}
+
+	struct MicroResult
+	{
+		std::string name;
+		uint64_t ops = 0;
+		double nsPerOp = 0.0;
+		double allocsPerOp = 0.0;
+		double bytesCopiedPerOp = 0.0;
+	};
+
+	struct MicroOptions
+	{
+		std::string filter;
+		std::chrono::milliseconds minTime{ 200 };
+		size_t repetitions = 3;
+		std::string csvPath;
+		std::string label;
+	};
+
+	struct MicroSample
+	{
+		uint64_t ops = 0;
+		uint64_t allocations = 0;
+		std::chrono::nanoseconds elapsed{ 0 };
+	};
+
+	class MicroBenchmarks
+	{
+	public:
+		explicit MicroBenchmarks(const MicroOptions& options) : options(options) {}
+
+		// body(ops) performs about ops operations and returns how many it actually did
+		template <typename TBody>
+		void Run(const std::string& name, double bytesCopiedPerOp, TBody&& body)
+		{
+			RunThreaded(name, 1, bytesCopiedPerOp, [&body](size_t, uint64_t ops) { return body(ops); });
+		}
+
+		// body(threadIndex, ops) runs on every thread at once, ns/op is the time one thread needs for one op
+		template <typename TBody>
+		void RunThreaded(const std::string& name, size_t threadCount, double bytesCopiedPerOp, TBody&& body)
+		{
+			if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+
+			uint64_t ops = 1;
+			while (true)
+			{
+				MicroSample sample = Measure(threadCount, ops, body);
+				if (sample.elapsed >= options.minTime / 10 || ops >= (1ull << 40)) break;
+				ops *= 10;
+			}
+			{
+				MicroSample sample = Measure(threadCount, ops, body);
+				double scale = static_cast<double>(options.minTime.count()) * 1e6 / std::max<double>(static_cast<double>(sample.elapsed.count()), 1.0);
+				ops = std::max<uint64_t>(static_cast<uint64_t>(static_cast<double>(ops) * scale), 1);
+			}
+
+			MicroResult result;
+			result.name = name;
+			for (size_t i = 0; i < std::max<size_t>(options.repetitions, 1); ++i)
+			{
+				MicroSample sample = Measure(threadCount, ops, body);
+				double nsPerOp = static_cast<double>(sample.elapsed.count()) / static_cast<double>(std::max<uint64_t>(sample.ops, 1));
+				if (result.ops == 0 || nsPerOp < result.nsPerOp)
+				{
+					result.ops = sample.ops;
+					result.nsPerOp = nsPerOp;
+					result.allocsPerOp = static_cast<double>(sample.allocations) / static_cast<double>(std::max<uint64_t>(sample.ops * threadCount, 1));
+					result.bytesCopiedPerOp = bytesCopiedPerOp;
+				}
+			}
+			Report(result);
+		}
+
+	private:
+		template <typename TBody>
+		MicroSample Measure(size_t threadCount, uint64_t ops, TBody& body)
+		{
+			if (threadCount == 1) return MeasureThread(0, ops, body);
+
+			std::vector<MicroSample> samples(threadCount);
+			std::vector<std::thread> threads;
+			std::atomic<size_t> ready = 0;
+			for (size_t i = 0; i < threadCount; ++i)
+			{
+				threads.emplace_back([&, i]() {
+					// Start together so that the threads actually contend
+					ready.fetch_add(1, std::memory_order_acq_rel);
+					while (ready.load(std::memory_order_acquire) != threadCount)
+					{
+						std::this_thread::yield();
+					}
+					samples[i] = MeasureThread(i, ops, body);
+				});
+			}
+
+			MicroSample total;
+			for (size_t i = 0; i < threadCount; ++i)
+			{
+				threads[i].join();
+				total.ops = std::max(total.ops, samples[i].ops);
+				total.allocations += samples[i].allocations;
+				total.elapsed = std::max(total.elapsed, samples[i].elapsed);
+			}
+			return total;
+		}
+
+		template <typename TBody>
+		static MicroSample MeasureThread(size_t threadIndex, uint64_t ops, TBody& body)
+		{
+			MicroSample sample;
+			uint64_t allocations = allocationCount;
+			Clock::time_point start = Clock::now();
+			sample.ops = body(threadIndex, ops);
+			sample.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+			sample.allocations = allocationCount - allocations;
+			return sample;
+		}
+
+		void Report(const MicroResult& result)
+		{
+			std::cout << std::format("{:<52} {:>10.1f} ns/op {:>8.2f} allocs/op {:>10.0f} B copied/op {:>12} ops",
+									 result.name,
+									 result.nsPerOp,
+									 result.allocsPerOp,
+									 result.bytesCopiedPerOp,
+									 result.ops)
+					  << std::endl;
+
+			if (options.csvPath.empty()) return;
+
+			bool writeHeader = !std::filesystem::exists(options.csvPath) || std::filesystem::file_size(options.csvPath) == 0;
+			std::ofstream csv(options.csvPath, std::ios::app);
+			if (!csv)
+			{
+				std::cerr << "Can't open " << options.csvPath << std::endl;
+				return;
+			}
+			if (writeHeader) csv << "label,name,ops,ns_per_op,allocs_per_op,bytes_copied_per_op\n";
+			csv << std::format("{},{},{},{:.2f},{:.3f},{:.0f}\n", options.label, result.name, result.ops, result.nsPerOp, result.allocsPerOp, result.bytesCopiedPerOp);
+		}
+
+	private:
+		MicroOptions options;
+	};
+
+	constexpr size_t bufferSize = 1024;
+
+	void BufferPoolBenchmarks(MicroBenchmarks& benchmarks)
+	{
+		// Pools are created outside of the measured body, so their setup doesn't show up in allocs/op
+		BufferPool<bufferSize> heapPool;
+		benchmarks.Run("BufferPool/TakeReturn/heap", 0.0, [&pool = heapPool](uint64_t ops) {
+			for (uint64_t i = 0; i < ops; ++i)
+			{
+				char* buffer = pool.TakeBuffer();
+				DoNotOptimize(buffer);
+				pool.ReturnBuffer(buffer);
+			}
+			return ops;
+		});
+		BufferPool<bufferSize> slabPool(SlabOptions{ .reserveBuffers = 1024 });
+		benchmarks.Run("BufferPool/TakeReturn/slab", 0.0, [&pool = slabPool](uint64_t ops) {
+			for (uint64_t i = 0; i < ops; ++i)
+			{
+				char* buffer = pool.TakeBuffer();
+				DoNotOptimize(buffer);
+				pool.ReturnBuffer(buffer);
+			}
+			return ops;
+		});
+		// One op is one buffer taken and returned, the burst walks the whole free queue
+		benchmarks.Run("BufferPool/Burst64/slab", 0.0, [&pool = slabPool](uint64_t ops) {
+			std::array<char*, 64> burst;
+			uint64_t rounds = (ops + burst.size() - 1) / burst.size();
+			for (uint64_t round = 0; round < rounds; ++round)
+			{
+				for (auto& buffer : burst)
+				{
+					buffer = pool.TakeBuffer();
+				}
+				DoNotOptimize(burst);
+				for (auto buffer : burst)
+				{
+					pool.ReturnBuffer(buffer);
+				}
+			}
+			return rounds * burst.size();
+		});
+
+		// BufferPool is owned by one thread, pools shared by several threads go through ConcurrentBufferPool and a BufferPoolCache per thread.
+		// Bursts of 8 stay in the cache, bursts of 256 exchange batches with the shared pool on every round.
+		for (size_t burstSize : { 8u, 256u })
+		{
+			for (size_t threadCount : { 1u, 2u, 4u, 8u })
+			{
+				ConcurrentBufferPool<bufferSize> sharedPool(4096);
+				benchmarks.RunThreaded(std::format("ConcurrentBufferPool/Burst{}/threads:{}", burstSize, threadCount),
+									   threadCount,
+									   0.0,
+									   [&sharedPool, burstSize](size_t, uint64_t ops) {
+										   BufferPoolCache<bufferSize> cache(sharedPool);
+										   std::array<char*, 256> burst;
+										   uint64_t rounds = (ops + burstSize - 1) / burstSize;
+										   for (uint64_t round = 0; round < rounds; ++round)
+										   {
+											   for (size_t i = 0; i < burstSize; ++i)
+											   {
+												   burst[i] = cache.TakeBuffer();
+											   }
+											   DoNotOptimize(burst);
+											   for (size_t i = 0; i < burstSize; ++i)
+											   {
+												   cache.ReturnBuffer(burst[i]);
+											   }
+										   }
+										   return rounds * burstSize;
+									   });
+			}
+		}
+	}
+
+	void BufferChainBenchmarks(MicroBenchmarks& benchmarks)
+	{
+		// One op is a whole life cycle: the chain is created, grows to the given length and returns its buffers when destroyed
+		BufferPool<bufferSize> pool(SlabOptions{ .reserveBuffers = 1024 });
+		for (size_t length : { 1u, 4u, 16u })
+		{
+			benchmarks.Run(std::format("BufferChain/Lifecycle/buffers:{}", length), 0.0, [&pool, length](uint64_t ops) {
+				for (uint64_t i = 0; i < ops; ++i)
+				{
+					BufferChain<bufferSize> chain(pool);
+					for (size_t j = 0; j < length; ++j)
+					{
+						DoNotOptimize(chain.TakeBuffer());
+					}
+				}
+				return ops;
+			});
+		}
+	}
+
+	void ConcatBenchmarks(MicroBenchmarks& benchmarks)
+	{
+		// The last buffer is half full and NUL-terminated like a received text message
+		for (size_t length : { 1u, 2u, 4u, 16u, 64u })
+		{
+			BufferPool<bufferSize> pool(SlabOptions{ .reserveBuffers = 1024 });
+			BufferChain<bufferSize> chain(pool);
+			for (size_t i = 0; i < length; ++i)
+			{
+				char* buffer = chain.TakeBuffer();
+				memset(buffer, 'x', bufferSize);
+			}
+			(*std::prev(chain.end()))[bufferSize / 2] = '\0';
+
+			double bytesCopied = static_cast<double>((length - 1) * bufferSize + bufferSize / 2);
+			benchmarks.Run(std::format("ConcatBuffers/buffers:{}", length), bytesCopied, [&chain](uint64_t ops) {
+				for (uint64_t i = 0; i < ops; ++i)
+				{
+					std::string message = chain.Concat();
+					DoNotOptimize(message);
+				}
+				return ops;
+			});
+		}
+	}
+
+	// Drives an event handler's Read the way a receive loop would, one op is one complete message handed to the connection
+	template <typename TNetEventHandler>
+	class ReadBench
+	{
+	public:
+		ReadBench() : socketContext(NetSocket(), &connection)
+		{
+			netEventHandler.StartRead(socketContext);
+		}
+
+		// Copies the chunk into the receive buffer as a recv would, then lets the handler consume it
+		void Receive(const char* chunk, uint32_t size)
+		{
+			memcpy(socketContext.receiveContext.netBuffer.buf, chunk, size);
+			netEventHandler.Read(socketContext, size);
+		}
+
+		// Drains the queue through Update, which keeps the connection's receive accounting as a server would
+		uint64_t TakeMessages()
+		{
+			uint64_t messages = connection.receivedMessages.size();
+			connection.Update(consumer);
+			return messages;
+		}
+
+	private:
+		struct MessageConsumer : NetConnectionHandlerBase
+		{
+			void OnMessage(NetConnection&, const NetReceivedMessage& message)
+			{
+				DoNotOptimize(message.msg);
+			}
+		};
+
+		MessageConsumer consumer;
+		TNetEventHandler netEventHandler;
+		NetConnection connection;
+		SocketContext socketContext;
+	};
+
+	void ReadBenchmarks(MicroBenchmarks& benchmarks)
+	{
+		for (size_t messageSize : { 64u, 1024u, 4096u, 65536u })
+		{
+			// NUL-terminated text: a message ends with the receive that ends with '\0', so every message needs its own receives
+			std::string message(messageSize, 'x');
+			message.back() = '\0';
+			ReadBench<NetEventHandler> textBench;
+			benchmarks.Run(std::format("NetEventHandler::Read/size:{}", messageSize), static_cast<double>(messageSize - 1), [&bench = textBench, &message](uint64_t ops) {
+				for (uint64_t i = 0; i < ops; ++i)
+				{
+					for (size_t offset = 0; offset < message.size(); offset += bufferSize)
+					{
+						bench.Receive(message.data() + offset, static_cast<uint32_t>(std::min(bufferSize, message.size() - offset)));
+					}
+					bench.TakeMessages();
+				}
+				return ops;
+			});
+
+			// Length-prefixed frames back to back, received in buffer-sized chunks that ignore message boundaries
+			std::string stream;
+			while (stream.size() < 64 * 1024)
+			{
+				stream += NetProtocolFramedTCP::Frame(std::string(messageSize, 'x'));
+			}
+			uint64_t framesPerStream = stream.size() / (messageSize + NetProtocolFramedTCP::headerSize);
+			ReadBench<NetFramedEventHandler> framedBench;
+			benchmarks.Run(std::format("NetFramedEventHandler::Read/size:{}", messageSize),
+						   static_cast<double>(messageSize + NetProtocolFramedTCP::headerSize),
+						   [&bench = framedBench, &stream, framesPerStream](uint64_t ops) {
+							   uint64_t messages = 0;
+							   uint64_t rounds = (ops + framesPerStream - 1) / framesPerStream;
+							   for (uint64_t round = 0; round < rounds; ++round)
+							   {
+								   for (size_t offset = 0; offset < stream.size(); offset += bufferSize)
+								   {
+									   bench.Receive(stream.data() + offset, static_cast<uint32_t>(std::min(bufferSize, stream.size() - offset)));
+									   messages += bench.TakeMessages();
+								   }
+							   }
+							   return messages;
+						   });
+		}
+	}
+}
+
+char* getCmdOption(char** begin, char** end, const std::string& option)
+{
+	char** itr = std::find(begin, end, option);
+	if (itr != end && ++itr != end) { return *itr; }
+	return nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+	using namespace LimeEngine::Net;
+	using namespace LimeEngine::Net::Benchmark;
+
+	MicroOptions options;
+	NetLogger::SetLevel(NetLogLevel::Off);
+
+	if (char* value = getCmdOption(argv, argv + argc, "--filter"); value != nullptr) { options.filter = value; }
+	if (char* value = getCmdOption(argv, argv + argc, "--min-time"); value != nullptr) { options.minTime = std::chrono::milliseconds(std::stoi(value)); }
+	if (char* value = getCmdOption(argv, argv + argc, "--repetitions"); value != nullptr) { options.repetitions = std::stoul(value); }
+	if (char* value = getCmdOption(argv, argv + argc, "--csv"); value != nullptr) { options.csvPath = value; }
+	if (char* value = getCmdOption(argv, argv + argc, "--label"); value != nullptr) { options.label = value; }
+
+#ifndef NDEBUG
+	std::cout << "Warning: built without NDEBUG, the numbers are not representative" << std::endl;
+#endif
+
+	MicroBenchmarks benchmarks(options);
+	BufferPoolBenchmarks(benchmarks);
+	BufferChainBenchmarks(benchmarks);
+	ConcatBenchmarks(benchmarks);
+	ReadBenchmarks(benchmarks);
+	return 0;
+}
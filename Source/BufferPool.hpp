@@ -4,9 +4,14 @@
 #pragma once
 #include <queue>
 #include <list>
+#include <array>
+#include <string>
 #include <cstddef>
+#include <cstring>
+#include <new>
 #include <sstream>
-#include "NetLogger.hpp"
+#include "SlabAllocator.hpp"
+#include "NetMetrics.hpp"
 
 namespace LimeEngine::Net
 {
@@ -48,55 +53,116 @@ namespace LimeEngine::Net
 	public:
 		explicit BufferPool(size_t bufferCount = 8)
 		{
-			NetLogger::LogCore("[InitBuffers {}]", bufferCount);
+			LENET_LOG_DEBUG(Pool, "[InitBuffers {}]", bufferCount);
 			for (int i = 0; i < bufferCount; ++i)
 			{
 				buffersQueue.push(buffers.emplace_back().data());
 			}
+			NetMetrics::Add(NetGauge::FreeBuffers, static_cast<int64_t>(bufferCount));
+		}
+		// Slab mode: buffers are carved out of large cache-line-aligned regions instead of one heap node per buffer
+		explicit BufferPool(const SlabOptions& slabOptions) : slabs(slabOptions.hugePages), useSlabs(true)
+		{
+			LENET_LOG_DEBUG(Pool, "[InitBuffers {} slab]", slabOptions.reserveBuffers);
+			while (slabs.Capacity() < slabOptions.reserveBuffers)
+			{
+				if (!AddSlab()) break;
+			}
+		}
+		BufferPool(BufferPool&& other) noexcept = default;
+		BufferPool& operator=(BufferPool&& other) noexcept = default;
+		~BufferPool()
+		{
+			NetMetrics::Add(NetGauge::FreeBuffers, -static_cast<int64_t>(buffersQueue.size()));
 		}
 
 		char* TakeBuffer()
 		{
 			if (buffersQueue.empty())
 			{
-				NetLogger::LogCore("[TakeBuffer +{}/{}]", buffersQueue.size(), buffers.size() + 1);
-				return buffers.emplace_back().data();
+				NetMetrics::Add(NetCounter::PoolMisses);
+				if (useSlabs)
+				{
+					// Like the heap mode, callers never get a null buffer
+					if (!AddSlab()) throw std::bad_alloc();
+				}
+				else
+				{
+					LENET_LOG_TRACE(Pool, "[TakeBuffer +{}/{}]", buffersQueue.size(), buffers.size() + 1);
+					return buffers.emplace_back().data();
+				}
 			}
 
-			NetLogger::LogCore("[TakeBuffer {}/{}]", buffersQueue.size() - 1, buffers.size());
+			LENET_LOG_TRACE(Pool, "[TakeBuffer {}/{}]", buffersQueue.size() - 1, Capacity());
 			auto buf = buffersQueue.front();
 			buffersQueue.pop();
+			NetMetrics::Add(NetCounter::PoolHits);
+			NetMetrics::Add(NetGauge::FreeBuffers, -1);
 			return buf;
 		}
 
 		void ReturnBuffer(char* returnBuffer)
 		{
-			NetLogger::LogCore("[ReturnBuffer {}/{}]", buffersQueue.size() + 1, buffers.size());
+			LENET_LOG_TRACE(Pool, "[ReturnBuffer {}/{}]", buffersQueue.size() + 1, Capacity());
 			buffersQueue.push(returnBuffer);
+			NetMetrics::Add(NetGauge::FreeBuffers, 1);
 		}
 
 		void ReturnBuffers(const std::list<char*>& returnBuffers)
 		{
-			NetLogger::LogCore("[ReturnBuffer {}/{}]", buffersQueue.size() + buffers.size(), buffers.size());
+			LENET_LOG_TRACE(Pool, "[ReturnBuffer {}/{}]", buffersQueue.size() + returnBuffers.size(), Capacity());
 			for (const auto& returnBuffer : returnBuffers)
 			{
 				buffersQueue.push(returnBuffer);
 			}
+			NetMetrics::Add(NetGauge::FreeBuffers, static_cast<int64_t>(returnBuffers.size()));
+		}
+
+		size_t Capacity() const noexcept
+		{
+			return useSlabs ? slabs.Capacity() : buffers.size();
+		}
+		bool IsSlabBacked() const noexcept
+		{
+			return useSlabs;
+		}
+		// Index of the buffer within the pool in O(1), slab mode only
+		size_t IndexOf(const char* buffer) const noexcept
+		{
+			return SlabAllocator<BufferSize>::IndexOf(buffer);
+		}
+
+	private:
+		bool AddSlab()
+		{
+			char* buffer = slabs.AddSlab();
+			if (buffer == nullptr) return false;
+
+			LENET_LOG_DEBUG(Pool, "[AddSlab {}/{}]", slabs.SlabCount(), slabs.Capacity());
+			for (size_t i = 0; i < SlabAllocator<BufferSize>::buffersPerSlab; ++i)
+			{
+				buffersQueue.push(buffer);
+				buffer += SlabAllocator<BufferSize>::bufferStride;
+			}
+			NetMetrics::Add(NetGauge::FreeBuffers, static_cast<int64_t>(SlabAllocator<BufferSize>::buffersPerSlab));
+			return true;
 		}
 
 	private:
 		std::queue<char*> buffersQueue;
 		std::list<std::array<char, BufferSize>> buffers;
+		SlabAllocator<BufferSize> slabs;
+		bool useSlabs = false;
 
 	public:
 		static constexpr size_t size = BufferSize;
 	};
 
-	template <size_t BufferSize>
+	template <size_t BufferSize, typename TBufferPool = BufferPool<BufferSize>>
 	class BufferChain
 	{
 	public:
-		explicit BufferChain(BufferPool<BufferSize>& bufferPool) : bufferPool(bufferPool) {}
+		explicit BufferChain(TBufferPool& bufferPool) : bufferPool(bufferPool) {}
 		~BufferChain()
 		{
 			for (auto& buffer : buffers)
@@ -156,7 +222,7 @@ namespace LimeEngine::Net
 		}
 
 	private:
-		BufferPool<BufferSize>& bufferPool;
+		TBufferPool& bufferPool;
 		std::list<char*> buffers;
 	};
 }
@@ -0,0 +1,283 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <atomic>
+#include <array>
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <cstddef>
+#include <new>
+#include "SlabAllocator.hpp"
+
+namespace LimeEngine::Net
+{
+	// Buffer pool shared by several event loop threads. Free buffers are kept in batches on a lock-free stack,
+	// so a thread touches the shared state once per batch. Every thread goes through its own BufferPoolCache.
+	template <size_t BufferSize, size_t BatchSize = 32>
+	class ConcurrentBufferPool
+	{
+		static_assert(BufferSize >= 3 * sizeof(uint64_t), "Free buffers store the batch links in place");
+		static_assert(BatchSize != 0);
+
+		using Slabs = SlabAllocator<BufferSize>;
+		static constexpr size_t chunkBufferCount = Slabs::buffersPerSlab;
+		static constexpr size_t maxChunks = 4096;
+
+		// Written into the first buffer of a free batch, the rest of the batch is linked through the first word of each buffer
+		struct FreeBatch
+		{
+			char* nextBuffer;
+			uint64_t nextBatch;
+			uint64_t count;
+		};
+
+	public:
+		ConcurrentBufferPool(const ConcurrentBufferPool&) = delete;
+		ConcurrentBufferPool& operator=(const ConcurrentBufferPool&) = delete;
+
+		explicit ConcurrentBufferPool(size_t bufferCount = chunkBufferCount, bool hugePages = false) : hugePages(hugePages)
+		{
+			while (chunkCount.load(std::memory_order_relaxed) * chunkBufferCount < bufferCount)
+			{
+				if (!AddChunk(nullptr)) break;
+			}
+		}
+		~ConcurrentBufferPool()
+		{
+			for (size_t i = 0; i < chunkCount.load(std::memory_order_acquire); ++i)
+			{
+				Slabs::DestroySlab(chunks[i].load(std::memory_order_relaxed));
+			}
+		}
+
+		// Returns up to BatchSize buffers linked through their first word
+		char* TakeBatch(size_t& outCount)
+		{
+			char* batch = PopBatch();
+			if (batch == nullptr && !AddChunk(&batch))
+			{
+				outCount = 0;
+				return nullptr;
+			}
+			outCount = Header(batch)->count;
+			return batch;
+		}
+
+		// Buffers must be linked through their first word, at most BatchSize of them
+		void ReturnBatch(char* batch, size_t count)
+		{
+			Header(batch)->count = count;
+			PushBatch(batch);
+		}
+
+		static char* NextInBatch(char* buffer) noexcept
+		{
+			return *reinterpret_cast<char**>(buffer);
+		}
+		static void LinkInBatch(char* buffer, char* next) noexcept
+		{
+			*reinterpret_cast<char**>(buffer) = next;
+		}
+
+		size_t Capacity() const noexcept
+		{
+			return chunkCount.load(std::memory_order_acquire) * chunkBufferCount;
+		}
+
+	private:
+		static FreeBatch* Header(char* buffer) noexcept
+		{
+			return reinterpret_cast<FreeBatch*>(buffer);
+		}
+
+		// Head of the free stack: 32-bit ABA tag and 32-bit (buffer index + 1), 0 means empty
+		static uint64_t MakeHead(uint32_t index, uint32_t tag) noexcept
+		{
+			return (static_cast<uint64_t>(tag) << 32) | index;
+		}
+		static uint32_t HeadIndex(uint64_t head) noexcept
+		{
+			return static_cast<uint32_t>(head);
+		}
+		static uint32_t HeadTag(uint64_t head) noexcept
+		{
+			return static_cast<uint32_t>(head >> 32);
+		}
+
+		char* BufferAt(uint32_t index) const noexcept
+		{
+			--index;
+			return chunks[index / chunkBufferCount].load(std::memory_order_acquire) + Slabs::firstBufferOffset + (index % chunkBufferCount) * Slabs::bufferStride;
+		}
+		// Slabs are registered under their index, a foreign buffer maps to an index that does not point back to its slab
+		uint32_t IndexOf(const char* buffer) const noexcept
+		{
+			uint32_t slabIndex = Slabs::SlabIndexOf(buffer);
+			if (slabIndex >= chunkCount.load(std::memory_order_acquire) || chunks[slabIndex].load(std::memory_order_relaxed) != Slabs::SlabOf(buffer)) return 0;
+			return static_cast<uint32_t>(Slabs::IndexOf(buffer) + 1);
+		}
+
+		char* PopBatch()
+		{
+			uint64_t head = freeBatches.load(std::memory_order_acquire);
+			while (HeadIndex(head) != 0)
+			{
+				char* batch = BufferAt(HeadIndex(head));
+				// The batch may be taken by another thread meanwhile, the tag makes the exchange fail in that case
+				uint64_t next = std::atomic_ref(Header(batch)->nextBatch).load(std::memory_order_relaxed);
+				if (freeBatches.compare_exchange_weak(head, MakeHead(static_cast<uint32_t>(next), HeadTag(head) + 1), std::memory_order_acquire, std::memory_order_acquire))
+				{
+					return batch;
+				}
+			}
+			return nullptr;
+		}
+
+		void PushBatch(char* batch)
+		{
+			uint32_t index = IndexOf(batch);
+			if (index == 0)
+			{
+				LENET_MSG_ERROR("Buffer does not belong to the ConcurrentBufferPool");
+				return;
+			}
+			uint64_t head = freeBatches.load(std::memory_order_relaxed);
+			do
+			{
+				std::atomic_ref(Header(batch)->nextBatch).store(HeadIndex(head), std::memory_order_relaxed);
+			} while (!freeBatches.compare_exchange_weak(head, MakeHead(index, HeadTag(head) + 1), std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		// Slow path, allocates a chunk and publishes its batches. One batch is handed out directly if requested.
+		bool AddChunk(char** outBatch)
+		{
+			std::lock_guard lock(growMutex);
+			if (outBatch != nullptr)
+			{
+				*outBatch = PopBatch();
+				if (*outBatch != nullptr) return true;
+			}
+
+			size_t chunkIndex = chunkCount.load(std::memory_order_relaxed);
+			if (chunkIndex == maxChunks)
+			{
+				LENET_MSG_ERROR("ConcurrentBufferPool is exhausted");
+				return false;
+			}
+			char* chunk = Slabs::CreateSlab(static_cast<uint32_t>(chunkIndex), hugePages);
+			if (chunk == nullptr) return false;
+			chunks[chunkIndex].store(chunk, std::memory_order_release);
+			chunkCount.store(chunkIndex + 1, std::memory_order_release);
+
+			chunk += Slabs::firstBufferOffset;
+			for (size_t first = 0; first < chunkBufferCount; first += BatchSize)
+			{
+				size_t count = std::min(BatchSize, chunkBufferCount - first);
+				char* batch = chunk + first * Slabs::bufferStride;
+				for (size_t i = 0; i + 1 < count; ++i)
+				{
+					LinkInBatch(batch + i * Slabs::bufferStride, batch + (i + 1) * Slabs::bufferStride);
+				}
+				LinkInBatch(batch + (count - 1) * Slabs::bufferStride, nullptr);
+				Header(batch)->count = count;
+
+				if (outBatch != nullptr && first == 0) { *outBatch = batch; }
+				else { PushBatch(batch); }
+			}
+			return true;
+		}
+
+	private:
+		alignas(CacheLineSize) std::atomic<uint64_t> freeBatches = 0;
+		alignas(CacheLineSize) std::atomic<size_t> chunkCount = 0;
+		std::array<std::atomic<char*>, maxChunks> chunks{};
+		std::mutex growMutex;
+		bool hugePages;
+
+	public:
+		static constexpr size_t size = BufferSize;
+		static constexpr size_t batchSize = BatchSize;
+	};
+
+	// Per-thread magazine in front of ConcurrentBufferPool with the same interface as BufferPool.
+	// Must only be used by the thread that owns it; buffers may be returned to a cache of another thread.
+	template <size_t BufferSize, size_t BatchSize = 32>
+	class BufferPoolCache
+	{
+	public:
+		BufferPoolCache(const BufferPoolCache&) = delete;
+		BufferPoolCache& operator=(const BufferPoolCache&) = delete;
+
+		explicit BufferPoolCache(ConcurrentBufferPool<BufferSize, BatchSize>& sharedPool) noexcept : sharedPool(sharedPool) {}
+		~BufferPoolCache()
+		{
+			while (count != 0)
+			{
+				Flush(std::min(count, BatchSize));
+			}
+		}
+
+		char* TakeBuffer()
+		{
+			// Same contract as BufferPool::TakeBuffer, callers never get a null buffer
+			if (count == 0 && !Refill()) throw std::bad_alloc();
+			return buffers[--count];
+		}
+
+		void ReturnBuffer(char* returnBuffer)
+		{
+			if (count == buffers.size()) Flush(BatchSize);
+			buffers[count++] = returnBuffer;
+		}
+
+		void ReturnBuffers(const std::list<char*>& returnBuffers)
+		{
+			for (const auto& returnBuffer : returnBuffers)
+			{
+				ReturnBuffer(returnBuffer);
+			}
+		}
+
+		size_t CachedCount() const noexcept
+		{
+			return count;
+		}
+
+	private:
+		bool Refill()
+		{
+			size_t batchCount;
+			char* buffer = sharedPool.TakeBatch(batchCount);
+			for (size_t i = 0; i < batchCount; ++i)
+			{
+				buffers[count++] = buffer;
+				buffer = sharedPool.NextInBatch(buffer);
+			}
+			return count != 0;
+		}
+
+		// Hands the oldest cached buffers back as one batch, the most recently returned (cache-hot) ones stay
+		void Flush(size_t flushCount)
+		{
+			for (size_t i = 0; i + 1 < flushCount; ++i)
+			{
+				sharedPool.LinkInBatch(buffers[i], buffers[i + 1]);
+			}
+			sharedPool.LinkInBatch(buffers[flushCount - 1], nullptr);
+			sharedPool.ReturnBatch(buffers[0], flushCount);
+
+			std::move(buffers.begin() + flushCount, buffers.begin() + count, buffers.begin());
+			count -= flushCount;
+		}
+
+	private:
+		ConcurrentBufferPool<BufferSize, BatchSize>& sharedPool;
+		std::array<char*, BatchSize * 2> buffers{};
+		size_t count = 0;
+
+	public:
+		static constexpr size_t size = BufferSize;
+	};
+}
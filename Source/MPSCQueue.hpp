@@ -0,0 +1,63 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <atomic>
+#include <utility>
+#include "NetBase.hpp"
+
+namespace LimeEngine::Net
+{
+	// Unbounded lock-free queue for any number of producer threads and one consumer thread (Vyukov's node-based MPSC queue).
+	// A push is one exchange, producers never wait for each other or for the consumer.
+	template <typename T>
+	class MPSCQueue
+	{
+		struct Node
+		{
+			std::atomic<Node*> next = nullptr;
+			T value{};
+		};
+
+	public:
+		MPSCQueue() noexcept : head(&stub), tail(&stub) {}
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+		~MPSCQueue()
+		{
+			T value;
+			while (Pop(value)) {}
+			if (tail != &stub) delete tail;
+		}
+
+		void Push(T value)
+		{
+			Node* node = new Node{ nullptr, std::move(value) };
+			Node* previous = head.exchange(node, std::memory_order_acq_rel);
+			// Until this store the consumer sees the queue end at previous, the producer then wakes it anyway
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		// Consumer thread only
+		bool Pop(T& outValue)
+		{
+			Node* next = tail->next.load(std::memory_order_acquire);
+			if (next == nullptr) return false;
+			outValue = std::move(next->value);
+			if (tail != &stub) delete tail;
+			tail = next;
+			return true;
+		}
+
+		// Consumer thread only
+		bool Empty() const noexcept
+		{
+			return tail->next.load(std::memory_order_acquire) == nullptr;
+		}
+
+	private:
+		alignas(CacheLineSize) std::atomic<Node*> head;
+		alignas(CacheLineSize) Node* tail;
+		Node stub;
+	};
+}
@@ -30,7 +30,7 @@ namespace LimeEngine::Net
 			char buf[INET_ADDRSTRLEN];
 			if (inet_ntop(AF_INET, &inAddr, buf, sizeof(buf)) == nullptr)
 			{
-				std::cout << "Error in IPv4 translation to string format " << WSAGetLastError() << std::endl;
+				std::cout << "Error in IPv4 translation to string format " << LENET_GET_LAST_ERROR() << std::endl;
 				return "invalid";
 			}
 			return buf;
@@ -51,14 +51,14 @@ namespace LimeEngine::Net
 		void Set(const std::string& addr)
 		{
 			int err = inet_pton(AF_INET6, addr.c_str(), &inAddr);
-			if (err <= 0) { LENET_ERROR(WSAGetLastError(), "Can't translate IPv6 to special numeric format"); }
+			if (err <= 0) { LENET_ERROR(LENET_GET_LAST_ERROR(), "Can't translate IPv6 to special numeric format"); }
 		}
 		std::string ToString()
 		{
 			char buf[INET6_ADDRSTRLEN];
 			if (inet_ntop(AF_INET6, &inAddr, buf, sizeof(buf)) == nullptr)
 			{
-				LENET_ERROR(WSAGetLastError(), "Can't translate IPv6 to string format");
+				LENET_ERROR(LENET_GET_LAST_ERROR(), "Can't translate IPv6 to string format");
 				return "invalid";
 			}
 			return buf;
@@ -71,6 +71,11 @@ namespace LimeEngine::Net
 	class NetSocketIPv4Address
 	{
 	public:
+		NetSocketIPv4Address() noexcept : addr{}
+		{
+			addr.sin_family = AF_INET;
+		}
+		explicit NetSocketIPv4Address(const sockaddr_in& addr) noexcept : addr(addr) {}
 		NetSocketIPv4Address(NetIPv4Address ip, uint16_t port)
 		{
 			addr.sin_family = AF_INET;
@@ -92,6 +97,16 @@ namespace LimeEngine::Net
 			return std::format("{}:{}", reinterpret_cast<NetIPv4Address*>(&addr.sin_addr)->ToString(), htons(addr.sin_port));
 		}
 
+		// Address and port in one value, identifies a datagram peer
+		uint64_t GetKey() const noexcept
+		{
+			return (static_cast<uint64_t>(ntohl(addr.sin_addr.s_addr)) << 16) | ntohs(addr.sin_port);
+		}
+		bool operator==(const NetSocketIPv4Address& rhs) const noexcept
+		{
+			return GetKey() == rhs.GetKey();
+		}
+
 	private:
 		sockaddr_in addr;
 	};
@@ -0,0 +1,193 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetAsyncLogger.hpp"
+#include <iterator>
+
+namespace LimeEngine::Net
+{
+	namespace
+	{
+		// Records are written once this much text is batched
+		constexpr size_t batchSize = 64 * 1024;
+
+		struct AsyncLoggerState
+		{
+			~AsyncLoggerState()
+			{
+				NetAsyncLogger::Stop();
+			}
+
+			std::mutex mutex;
+			std::vector<std::unique_ptr<NetLogRing>> rings;
+			std::thread thread;
+			FILE* file = nullptr;
+			std::chrono::milliseconds idleInterval{ 1 };
+			std::string batch;
+
+			std::atomic<uint64_t> written = 0;
+			std::atomic<uint64_t> truncated = 0;
+			// Counters of rings that were freed after their thread exited
+			uint64_t retiredDropped = 0;
+			uint64_t retiredBlocked = 0;
+
+			std::atomic<uint64_t> flushRequested = 0;
+			std::atomic<uint64_t> flushCompleted = 0;
+		};
+
+		AsyncLoggerState& State()
+		{
+			static AsyncLoggerState state;
+			return state;
+		}
+	}
+
+	bool NetAsyncLogger::Start(const NetAsyncLogOptions& options)
+	{
+		auto& state = State();
+		std::lock_guard lock(state.mutex);
+		if (IsRunning()) return false;
+
+		if (options.filePath.empty()) { state.file = stdout; }
+		else
+		{
+			state.file = fopen(options.filePath.c_str(), "a");
+			if (state.file == nullptr) return false;
+		}
+		state.idleInterval = options.idleInterval;
+		state.batch.reserve(batchSize + NetLogRecord::size * 2);
+		overflow.store(options.overflow, std::memory_order_relaxed);
+
+		running.store(true, std::memory_order_release);
+		state.thread = std::thread(&NetAsyncLogger::Run);
+		return true;
+	}
+
+	void NetAsyncLogger::Stop()
+	{
+		auto& state = State();
+		{
+			std::lock_guard lock(state.mutex);
+			if (!IsRunning()) return;
+			running.store(false, std::memory_order_release);
+		}
+		state.thread.join();
+		// Wakes producers that wait for a flush which will no longer happen
+		state.flushCompleted.store(state.flushRequested.load(std::memory_order_acquire), std::memory_order_release);
+		state.flushCompleted.notify_all();
+
+		if (state.file != stdout) fclose(state.file);
+		state.file = nullptr;
+	}
+
+	void NetAsyncLogger::Flush()
+	{
+		if (!IsRunning()) return;
+
+		auto& state = State();
+		uint64_t request = state.flushRequested.fetch_add(1, std::memory_order_acq_rel) + 1;
+		uint64_t completed = state.flushCompleted.load(std::memory_order_acquire);
+		while (completed < request && IsRunning())
+		{
+			state.flushCompleted.wait(completed, std::memory_order_acquire);
+			completed = state.flushCompleted.load(std::memory_order_acquire);
+		}
+	}
+
+	NetLogStats NetAsyncLogger::Stats()
+	{
+		auto& state = State();
+		std::lock_guard lock(state.mutex);
+
+		NetLogStats stats;
+		stats.written = state.written.load(std::memory_order_relaxed);
+		stats.truncated = state.truncated.load(std::memory_order_relaxed);
+		stats.dropped = state.retiredDropped;
+		stats.blocked = state.retiredBlocked;
+		for (auto& ring : state.rings)
+		{
+			stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+			stats.blocked += ring->blocked.load(std::memory_order_relaxed);
+		}
+		return stats;
+	}
+
+	NetLogRing* NetAsyncLogger::RegisterThread()
+	{
+		auto& state = State();
+		std::lock_guard lock(state.mutex);
+		threadRing.ring = state.rings.emplace_back(std::make_unique<NetLogRing>()).get();
+		return threadRing.ring;
+	}
+
+	void NetAsyncLogger::Run()
+	{
+		auto& state = State();
+		while (IsRunning())
+		{
+			uint64_t flushRequest = state.flushRequested.load(std::memory_order_acquire);
+			size_t drained = Drain();
+			if (flushRequest != state.flushCompleted.load(std::memory_order_relaxed))
+			{
+				state.flushCompleted.store(flushRequest, std::memory_order_release);
+				state.flushCompleted.notify_all();
+			}
+			if (drained == 0) std::this_thread::sleep_for(state.idleInterval);
+		}
+		// Records that were committed before Stop
+		Drain();
+	}
+
+	size_t NetAsyncLogger::Drain()
+	{
+		auto& state = State();
+		std::lock_guard lock(state.mutex);
+
+		size_t drained = 0;
+		auto write = [&state]() {
+			if (state.batch.empty()) return;
+			fwrite(state.batch.data(), 1, state.batch.size(), state.file);
+			state.batch.clear();
+		};
+
+		for (size_t i = 0; i < state.rings.size();)
+		{
+			NetLogRing& ring = *state.rings[i];
+			// Checked before draining, so no record committed before the thread exited is missed
+			bool abandoned = ring.abandoned.load(std::memory_order_acquire);
+
+			while (NetLogRecord* record = ring.Front())
+			{
+				std::format_to(std::back_inserter(state.batch), "[{} {}ms] ", record->source, record->timestamp);
+				state.batch.append(record->text, record->textSize);
+				if (record->truncated)
+				{
+					state.batch.append("...");
+					state.truncated.fetch_add(1, std::memory_order_relaxed);
+				}
+				state.batch.push_back('\n');
+				ring.Pop();
+				++drained;
+
+				if (state.batch.size() >= batchSize) write();
+			}
+
+			if (abandoned)
+			{
+				state.retiredDropped += ring.dropped.load(std::memory_order_relaxed);
+				state.retiredBlocked += ring.blocked.load(std::memory_order_relaxed);
+				state.rings[i] = std::move(state.rings.back());
+				state.rings.pop_back();
+			}
+			else { ++i; }
+		}
+
+		write();
+		if (drained != 0)
+		{
+			fflush(state.file);
+			state.written.fetch_add(drained, std::memory_order_relaxed);
+		}
+		return drained;
+	}
+}
@@ -0,0 +1,206 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <format>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+namespace LimeEngine::Net
+{
+	enum class NetLogOverflow
+	{
+		// The record is discarded and counted
+		Drop,
+		// The producer waits until the writer thread makes room
+		Block
+	};
+
+	struct NetAsyncLogOptions
+	{
+		NetLogOverflow overflow = NetLogOverflow::Drop;
+		// Empty to write to stdout
+		std::string filePath;
+		// How long the writer thread sleeps when every ring is empty
+		std::chrono::milliseconds idleInterval{ 1 };
+	};
+
+	struct NetLogStats
+	{
+		uint64_t written = 0;
+		uint64_t dropped = 0;
+		// Number of records whose producer had to wait for room
+		uint64_t blocked = 0;
+		uint64_t truncated = 0;
+	};
+
+	struct NetLogRecord
+	{
+		static constexpr size_t size = 256;
+		static constexpr size_t maxTextSize = size - 24;
+
+		// Milliseconds since the logger started
+		int64_t timestamp;
+		const char* source;
+		uint32_t textSize;
+		bool truncated;
+		char text[maxTextSize];
+	};
+	static_assert(sizeof(NetLogRecord) == NetLogRecord::size);
+
+	// Records of one producer thread, lock-free between that thread and the writer thread. Records are formatted in place.
+	class NetLogRing
+	{
+	public:
+		static constexpr size_t capacity = 1024;
+
+		NetLogRecord* Reserve() noexcept
+		{
+			size_t currentTail = tail.load(std::memory_order_relaxed);
+			if (currentTail - cachedHead == capacity)
+			{
+				cachedHead = head.load(std::memory_order_acquire);
+				if (currentTail - cachedHead == capacity) return nullptr;
+			}
+			return &records[currentTail & (capacity - 1)];
+		}
+		void Commit() noexcept
+		{
+			tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		// Writer thread only
+		NetLogRecord* Front() noexcept
+		{
+			size_t currentHead = head.load(std::memory_order_relaxed);
+			if (currentHead == cachedTail)
+			{
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (currentHead == cachedTail) return nullptr;
+			}
+			return &records[currentHead & (capacity - 1)];
+		}
+		void Pop() noexcept
+		{
+			head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+	public:
+		// Written by the producer only
+		std::atomic<uint64_t> dropped = 0;
+		std::atomic<uint64_t> blocked = 0;
+		// Set when the producer thread exits, the writer thread frees the ring once it is drained
+		std::atomic<bool> abandoned = false;
+
+	private:
+		alignas(64) std::atomic<size_t> head = 0;
+		size_t cachedTail = 0;
+		alignas(64) std::atomic<size_t> tail = 0;
+		size_t cachedHead = 0;
+		alignas(64) std::array<NetLogRecord, capacity> records;
+	};
+
+	// Owned by a thread_local, hands the thread's ring over to the writer thread when the thread exits
+	struct NetLogThreadRing
+	{
+		~NetLogThreadRing()
+		{
+			if (ring != nullptr) ring->abandoned.store(true, std::memory_order_release);
+		}
+
+		NetLogRing* ring = nullptr;
+	};
+
+	// Producers format into a ring of their own thread, without locks, allocations or syscalls.
+	// A background thread adds the prefix and writes the records in batches.
+	class NetAsyncLogger
+	{
+		NetAsyncLogger() = delete;
+
+	public:
+		static bool Start(const NetAsyncLogOptions& options = {});
+		// Writes every pending record before it returns
+		static void Stop();
+		static bool IsRunning() noexcept
+		{
+			return running.load(std::memory_order_acquire);
+		}
+		// Waits until every record logged before the call is written
+		static void Flush();
+		static NetLogStats Stats();
+
+		template <typename... TArgs>
+		static void Log(const char* source, const std::format_string<TArgs...> formatMsg, TArgs&&... args)
+		{
+			NetLogRecord* record = ReserveRecord();
+			if (record == nullptr) return;
+
+			auto result = std::format_to_n(record->text, NetLogRecord::maxTextSize, formatMsg, std::forward<TArgs>(args)...);
+			FinishRecord(*record, source, static_cast<size_t>(result.size));
+		}
+		static void Log(const char* source, std::string_view msg)
+		{
+			NetLogRecord* record = ReserveRecord();
+			if (record == nullptr) return;
+
+			memcpy(record->text, msg.data(), std::min(msg.size(), NetLogRecord::maxTextSize));
+			FinishRecord(*record, source, msg.size());
+		}
+
+		static int64_t ElapsedMilliseconds() noexcept
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+		}
+
+	private:
+		static NetLogRecord* ReserveRecord()
+		{
+			NetLogRing* ring = threadRing.ring;
+			if (ring == nullptr) ring = RegisterThread();
+
+			NetLogRecord* record = ring->Reserve();
+			if (record != nullptr) return record;
+
+			if (overflow.load(std::memory_order_relaxed) == NetLogOverflow::Block)
+			{
+				ring->blocked.fetch_add(1, std::memory_order_relaxed);
+				while (IsRunning())
+				{
+					std::this_thread::yield();
+					if ((record = ring->Reserve()) != nullptr) return record;
+				}
+			}
+			ring->dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		static void FinishRecord(NetLogRecord& record, const char* source, size_t textSize) noexcept
+		{
+			record.timestamp = ElapsedMilliseconds();
+			record.source = source;
+			record.truncated = textSize > NetLogRecord::maxTextSize;
+			record.textSize = static_cast<uint32_t>(std::min(textSize, NetLogRecord::maxTextSize));
+			threadRing.ring->Commit();
+		}
+
+		static NetLogRing* RegisterThread();
+		static void Run();
+		static size_t Drain();
+
+	private:
+		inline static thread_local NetLogThreadRing threadRing;
+		inline static std::atomic<bool> running = false;
+		inline static std::atomic<NetLogOverflow> overflow = NetLogOverflow::Drop;
+		inline static const auto startTime = std::chrono::steady_clock::now();
+	};
+}
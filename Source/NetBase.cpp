@@ -5,8 +5,9 @@
 
 namespace LimeEngine::Net
 {
-	std::string GetWSAErrorMessage(int err)
+	std::string GetNetErrorMessage(int err)
 	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		char* s = nullptr;
 		FormatMessageA(
 			FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
@@ -19,5 +20,8 @@ namespace LimeEngine::Net
 		std::string msg = s;
 		LocalFree(s);
 		return msg;
+#else
+		return std::system_category().message(err);
+#endif
 	}
 }
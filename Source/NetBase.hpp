@@ -16,39 +16,92 @@
 #include <functional>
 #include <format>
 #include <chrono>
+#include <system_error>
 
-#include <WinSock2.h>
-#include <WS2tcpip.h>
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	#include <WinSock2.h>
+	#include <WS2tcpip.h>
+#else
+	#include <cerrno>
+	#include <csignal>
+	#include <sys/types.h>
+	#include <sys/socket.h>
+	#include <sys/uio.h>
+	#include <sys/select.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <netinet/udp.h>
+	#include <arpa/inet.h>
+	#include <poll.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
 
 #include "WinSocketError.hpp"
+#include "PosixSocketError.hpp"
 #include "NetLogger.hpp"
 
-#define LENET_ERROR(err, msg)                                                                                                                     \
-	{                                                                                                                                             \
-		int _err = err;                                                                                                                           \
-		::LimeEngine::Net::NetLogger::LogCore(                                                                                                    \
-			"{}:{} Error: code {}({}), {}\n desc: {}", __FILE__, __LINE__, _err, GetWinSocketErrorCodeName(_err), msg, GetWSAErrorMessage(_err)); \
-		__debugbreak();                                                                                                                           \
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	#define LENET_DEBUG_BREAK()        __debugbreak()
+	#define LENET_GET_LAST_ERROR()     WSAGetLastError()
+	#define LENET_ERROR_CODE_NAME(err) GetWinSocketErrorCodeName(err)
+#else
+	#define LENET_DEBUG_BREAK()        raise(SIGTRAP)
+	#define LENET_GET_LAST_ERROR()     errno
+	#define LENET_ERROR_CODE_NAME(err) GetPosixSocketErrorCodeName(err)
+#endif
+
+#define LENET_ERROR(err, msg)                                                                                                                               \
+	{                                                                                                                                                       \
+		int _err = err;                                                                                                                                     \
+		::LimeEngine::Net::NetLogger::Log(                                                                                                                  \
+			::LimeEngine::Net::NetLogCategory::IO,                                                                                                          \
+			"{}:{} Error: code {}({}), {}\n desc: {}", __FILE__, __LINE__, _err, LENET_ERROR_CODE_NAME(_err), msg, ::LimeEngine::Net::GetNetErrorMessage(_err)); \
+		::LimeEngine::Net::NetLogger::Flush();                                                                                                              \
+		LENET_DEBUG_BREAK();                                                                                                                                \
 	}
 
 #define LENET_MSG_ERROR(msg)                                                \
 	{                                                                       \
-		::LimeEngine::Net::NetLogger::NetLogger::LogCore("Error: {}", msg); \
-		__debugbreak();                                                     \
+		::LimeEngine::Net::NetLogger::Log(                                  \
+			::LimeEngine::Net::NetLogCategory::IO, "Error: {}", msg);       \
+		::LimeEngine::Net::NetLogger::Flush();                              \
+		LENET_DEBUG_BREAK();                                                \
 	}
 
-#define LENET_LASTERR             std::error_code(WSAGetLastError(), std::system_category())
+#define LENET_LASTERR             std::error_code(LENET_GET_LAST_ERROR(), std::system_category())
 
-#define LENET_LAST_ERROR()        LENET_ERROR(WSAGetLastError())
-#define LENET_LAST_ERROR_MSG(msg) LENET_ERROR(WSAGetLastError(), msg)
+#define LENET_LAST_ERROR()        LENET_ERROR(LENET_GET_LAST_ERROR())
+#define LENET_LAST_ERROR_MSG(msg) LENET_ERROR(LENET_GET_LAST_ERROR(), msg)
 
 namespace LimeEngine::Net
 {
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	using NativeSocket = SOCKET;
 	using NativeIOContext = OVERLAPPED;
 	using NetBuffer = WSABUF;
 
 	static constexpr NativeSocket InvalidNativeSocket = INVALID_SOCKET;
+	static constexpr int NativeSocketError = SOCKET_ERROR;
+#else
+	using NativeSocket = int;
+
+	// Completion-based backends on POSIX tag their submissions directly, there is no OVERLAPPED equivalent
+	struct NativeIOContext
+	{};
+
+	// Same member order as WSABUF
+	struct NetBuffer
+	{
+		uint32_t len;
+		char* buf;
+	};
+
+	static constexpr NativeSocket InvalidNativeSocket = -1;
+	static constexpr int NativeSocketError = -1;
+#endif
+
+	static constexpr size_t CacheLineSize = 64;
 
-	std::string GetWSAErrorMessage(int err);
+	std::string GetNetErrorMessage(int err);
 }
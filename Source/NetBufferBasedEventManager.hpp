@@ -3,6 +3,7 @@
 
 #pragma once
 #include "NetEventHandler.hpp"
+#include "NetWaitStrategy.hpp"
 
 namespace LimeEngine::Net
 {
@@ -14,7 +15,9 @@ namespace LimeEngine::Net
 		NetBufferBasedEventManager operator=(const NetBufferBasedEventManager& other) = delete;
 
 		NetBufferBasedEventManager(NetBufferBasedEventManager&& other) noexcept :
-			netEventHandler(std::move(other.netEventHandler)), netEventBuffer(std::move(other.netEventBuffer)), socketContexts(std::move(other.socketContexts))
+			netEventHandler(std::move(other.netEventHandler)), netEventBuffer(std::move(other.netEventBuffer)), pendingWrites(std::move(other.pendingWrites)),
+			socketContexts(std::move(other.socketContexts)),
+			pausedReads(std::move(other.pausedReads))
 		{}
 		NetBufferBasedEventManager& operator=(NetBufferBasedEventManager&& other) noexcept
 		{
@@ -22,7 +25,9 @@ namespace LimeEngine::Net
 			{
 				netEventHandler = std::move(other.netEventHandler);
 				netEventBuffer = std::move(other.netEventBuffer);
+				pendingWrites = std::move(other.pendingWrites);
 				socketContexts = std::move(other.socketContexts);
+				pausedReads = std::move(other.pausedReads);
 			}
 			return *this;
 		}
@@ -33,7 +38,11 @@ namespace LimeEngine::Net
 		void AddConnection(NetSocket&& socket, NetConnection& connection)
 		{
 			auto& socketContext = socketContexts.emplace_back(std::make_unique<SocketContext>(std::move(socket), &connection));
+			socketContext->index = socketContexts.size() - 1;
+			// Edge-triggered reads and writes loop until the call would block, which a blocking socket never reports
+			if constexpr (TNetEventBuffer::edgeTriggered) socketContext->socket.SetNonblockingMode();
 			netEventBuffer.Add(socketContext->socket.GetNativeSocket());
+			connection.AttachPendingWrites(&pendingWrites, &socketContext->pendingWrite);
 			netEventHandler.StartRead(*socketContext);
 		}
 
@@ -44,96 +53,174 @@ namespace LimeEngine::Net
 				netEventHandler.Disconnect(*socketContext);
 			}
 			socketContexts.clear();
+			pausedReads.clear();
 		}
 
 	private:
+		// Swap-and-pop in both the context list and the event buffer, so they stay index-aligned
 		void RemoveConnection(size_t index)
 		{
 			if (netEventHandler.Disconnect(*socketContexts[index]))
 			{
+				if (socketContexts[index]->readPaused) std::erase(pausedReads, socketContexts[index].get());
 				netEventBuffer.Remove(index);
-				socketContexts.erase(std::begin(socketContexts) + index);
+				if (index != socketContexts.size() - 1)
+				{
+					socketContexts[index] = std::move(socketContexts.back());
+					socketContexts[index]->index = index;
+				}
+				socketContexts.pop_back();
 			}
 		}
 		void RemoveConnection(SocketContext* socketContext)
 		{
-			auto socketContextIter = std::find_if(
-				std::begin(socketContexts), std::end(socketContexts), [socketContext](const std::unique_ptr<SocketContext>& item) { return item.get() == socketContext; });
-			if (socketContextIter != std::end(socketContexts))
+			RemoveConnection(socketContext->index);
+		}
+
+		// Removal moves the last context, so it is deferred while the events of the current wait are being visited
+		void RemovePendingConnections()
+		{
+			for (SocketContext* socketContext : pendingRemovals)
+			{
+				RemoveConnection(socketContext);
+			}
+			pendingRemovals.clear();
+		}
+
+		// The socket stays registered, so hangups and errors are still reported while reading is paused
+		void PauseRead(SocketContext& socketContext)
+		{
+			socketContext.readPaused = true;
+			netEventBuffer.ResetReadFlag(socketContext.index);
+			pausedReads.push_back(&socketContext);
+		}
+
+		// Reading resumes once Update has drained the receive queue to its low watermark
+		void ResumeReads()
+		{
+			for (size_t i = 0; i < pausedReads.size();)
 			{
-				if (netEventHandler.Disconnect(*socketContext))
+				SocketContext* socketContext = pausedReads[i];
+				if (socketContext->connection->IsReceiveBlocked())
 				{
-					netEventBuffer.Remove(std::distance(std::begin(socketContexts), socketContextIter));
-					socketContexts.erase(socketContextIter);
+					++i;
+					continue;
 				}
+				socketContext->readPaused = false;
+				netEventBuffer.SetReadFlag(socketContext->index);
+				pausedReads[i] = pausedReads.back();
+				pausedReads.pop_back();
 			}
 		}
 
+		// Only connections that queued a message while idle are visited, SendData continues the others
 		void ProcessSend()
 		{
-			for (size_t i = 0; i < netEventBuffer.Count(); ++i)
+			pendingWrites.Drain([this](SocketContext& socketContext) {
+				if (netEventHandler.StartWrite(socketContext)) { netEventBuffer.SetWriteFlag(socketContext.index); }
+			});
+		}
+
+		// Returns false if the connection must be removed
+		bool ReceiveData(SocketContext& socketContext)
+		{
+			int bytesTransferred;
+			// Edge-triggered buffers report readiness once, so read until the socket would block.
+			// A short read doesn't mean drained, a FIN that arrived with the last data is only seen by the next read.
+			do
 			{
-				if (netEventHandler.StartWrite(*socketContexts[i])) { netEventBuffer.SetWriteFlag(i); }
-			}
+				NetBuffer& netBuffer = socketContext.receiveContext.netBuffer;
+				NetMetrics::Add(NetCounter::Syscalls);
+				if (!TNetProtocol::Receive(socketContext.socket, netBuffer.buf, netBuffer.len, bytesTransferred))
+				{
+					if (bytesTransferred < 0) return true;
+					LENET_LOG_DEBUG(IO, "Receive=0, Client {} disconnected", socketContext.socket.GetId());
+					return false;
+				}
+				NetMetrics::Add(NetCounter::BytesIn, bytesTransferred);
+				netEventHandler.Read(socketContext, bytesTransferred);
+				if (socketContext.connection->IsReceiveBlocked())
+				{
+					PauseRead(socketContext);
+					return true;
+				}
+			} while (TNetEventBuffer::edgeTriggered);
+			return true;
+		}
+
+		// Returns false if the connection must be removed
+		bool SendData(SocketContext& socketContext, size_t index)
+		{
+			int bytesTransferred;
+			do
+			{
+				IOContext& sendContext = socketContext.sendContext;
+				NetMetrics::Add(NetCounter::Syscalls);
+				if (!TNetProtocol::SendBuffers(socketContext.socket, sendContext.GetNetBuffers(), sendContext.GetNetBufferCount(), bytesTransferred))
+				{
+					if (bytesTransferred < 0) return true;
+					LENET_LOG_DEBUG(IO, "Send=0, Client {} disconnected", socketContext.socket.GetId());
+					return false;
+				}
+				NetMetrics::Add(NetCounter::BytesOut, bytesTransferred);
+				if (!netEventHandler.Write(socketContext, bytesTransferred))
+				{
+					netEventBuffer.ResetWriteFlag(index);
+					return true;
+				}
+			} while (TNetEventBuffer::edgeTriggered);
+			return true;
 		}
 
 	public:
+		// Returns whether any event was handled
 		bool HandleNetEvents(uint32_t timeout = 1u)
 		{
-			if (netEventBuffer.Empty()) return true;
+			if (netEventBuffer.Empty()) return false;
 
+			ResumeReads();
 			ProcessSend();
 
-			int pollResult = netEventBuffer.WaitForEvents(timeout);
-			if (pollResult == 0) return true;
+			int pollResult = TimedWait(timeout, [this, timeout]() { return netEventBuffer.WaitForEvents(timeout); });
+			NetMetrics::Add(NetCounter::Syscalls);
+			NetMetrics::Add(NetCounter::Wakeups);
+			if (pollResult == 0)
+			{
+				NetMetrics::Add(NetCounter::EmptyWakeups);
+				return false;
+			}
 
-			netEventBuffer.Log();
+			if (LENET_LOG_ENABLED(Trace, Poll)) netEventBuffer.Log();
 
-			for (int i = 0; i < netEventBuffer.Count(); ++i)
+			for (size_t eventIndex = 0; eventIndex < netEventBuffer.EventsCount(); ++eventIndex)
 			{
 				if (pollResult == 0) break;
 
+				size_t i = netEventBuffer.EventSocketIndex(eventIndex);
 				SocketContext& socketContext = *socketContexts[i];
-				auto&& netEvent = netEventBuffer.At(i);
+				auto&& netEvent = netEventBuffer.EventAt(eventIndex);
 
 				if (netEvent.IsChanged()) --pollResult;
 
 				//  Read
-				if (netEvent.CheckRead())
+				if (netEvent.CheckRead() && !ReceiveData(socketContext))
 				{
-					int bytesTransferred;
-					NetBuffer& netBuffer = socketContext.receiveContext.netBuffer;
-					if (TNetProtocol::Receive(socketContext.socket, netBuffer.buf, netBuffer.len, bytesTransferred)) { netEventHandler.Read(socketContext, bytesTransferred); }
-					else
-					{
-						NetLogger::LogCore("Receive=0, Client {} disconnected", socketContext.socket.GetId());
-						RemoveConnection(i);
-						continue;
-					}
+					pendingRemovals.push_back(&socketContext);
+					continue;
 				}
 
 				// Write
-				if (netEvent.CheckWrite() && netEventHandler.ReadyToWrite(socketContext))
+				if (netEvent.CheckWrite() && netEventHandler.ReadyToWrite(socketContext) && !SendData(socketContext, i))
 				{
-					int bytesTransferred;
-					NetBuffer& netBuffer = socketContext.sendContext.netBuffer;
-					if (TNetProtocol::Send(socketContext.socket, netBuffer.buf, netBuffer.len, bytesTransferred))
-					{
-						if (!netEventHandler.Write(socketContext, bytesTransferred)) { netEventBuffer.ResetWriteFlag(i); }
-					}
-					else
-					{
-						NetLogger::LogCore("Send=0, Client {} disconnected", socketContext.socket.GetId());
-						RemoveConnection(i);
-						continue;
-					}
+					pendingRemovals.push_back(&socketContext);
+					continue;
 				}
 
 				// Disconnections
 				if (netEvent.CheckDisconnect())
 				{
-					NetLogger::LogCore("Client {} disconnected", socketContext.socket.GetId());
-					RemoveConnection(i);
+					LENET_LOG_DEBUG(IO, "Client {} disconnected", socketContext.socket.GetId());
+					pendingRemovals.push_back(&socketContext);
 					continue;
 				}
 
@@ -141,13 +228,20 @@ namespace LimeEngine::Net
 				if (netEvent.CheckExcept())
 				{
 					LENET_LAST_ERROR_MSG("Unable to read from client");
-					RemoveConnection(i);
+					pendingRemovals.push_back(&socketContext);
 					continue;
 				}
 			}
+			RemovePendingConnections();
 			return true;
 		}
 
+		// Any thread, interrupts the current or the next wait
+		void Wake()
+		{
+			netEventBuffer.Wake();
+		}
+
 		bool HasConnections() const
 		{
 			return !socketContexts.empty();
@@ -160,6 +254,10 @@ namespace LimeEngine::Net
 	private:
 		TNetEventHandler netEventHandler;
 		TNetEventBuffer netEventBuffer;
+		// Declared before the contexts, whose links unlink themselves when they are destroyed
+		NetPendingWriteList pendingWrites;
 		std::vector<std::unique_ptr<SocketContext>> socketContexts;
+		std::vector<SocketContext*> pendingRemovals;
+		std::vector<SocketContext*> pausedReads;
 	};
 }
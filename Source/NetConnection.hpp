@@ -3,8 +3,20 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <queue>
+#include <deque>
 #include <functional>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include "NetSockets.hpp"
+#include "NetTimerWheel.hpp"
+#include "NetMetrics.hpp"
+#include "NetReadyList.hpp"
+#include "NetPendingWriteList.hpp"
 
 namespace LimeEngine::Net
 {
@@ -29,6 +41,36 @@ namespace LimeEngine::Net
 		std::string msg;
 	};
 
+	// Message received in place, only valid during the callback. Copy it into a NetReceivedMessage to keep it.
+	using NetMessageView = std::string_view;
+
+	// Generation-checked handle, unique for the lifetime of the server
+	using NetConnectionId = uint64_t;
+
+	class NetConnection;
+	class NetFunctionHandler;
+
+	// Plain function pointer into a statically typed handler, set by the server for handlers with OnMessageView
+	using NetMessageViewDispatch = void (*)(void* handler, NetConnection& connection, NetMessageView message);
+	// Same for handlers with OnSendPressure
+	using NetSendPressureDispatch = void (*)(void* handler, NetConnection& connection, bool blocked);
+
+	// Queue limits in bytes. Reaching high blocks the queue, it is unblocked once it drains to low or below. A zero high disables them.
+	struct NetWatermarks
+	{
+		size_t high = 0;
+		size_t low = 0;
+	};
+
+	// What a send that takes the send queue to its high watermark does
+	enum class NetSendOverflow : uint8_t
+	{
+		// Calls OnSendPressure(true), and OnSendPressure(false) once the queue has drained to the low watermark
+		Notify,
+		// Closes the connection, for peers that don't read fast enough
+		Close
+	};
+
 	enum class NetStatus
 	{
 		Init,
@@ -41,14 +83,14 @@ namespace LimeEngine::Net
 	class NetConnection
 	{
 	public:
-		NetConnection()
-		{
-			static uint16_t idCounter = 0;
-			Id = idCounter++;
-		}
+		// The id is the connection's handle in the server's connection map
+		explicit NetConnection(NetConnectionId id = 0) : Id(id) {}
 		~NetConnection()
 		{
-			if (status == NetStatus::MarkForClose) { onDisconnect(*this); }
+			CancelTimers();
+			if (queuedSendBytes != 0) NetMetrics::Add(NetGauge::QueuedSendBytes, -queuedSendBytes);
+			if (queuedReceiveBytes != 0) NetMetrics::Add(NetGauge::QueuedReceiveBytes, -queuedReceiveBytes);
+			if (status == NetStatus::MarkForClose && onDisconnect) { onDisconnect(*this); }
 		}
 
 		bool operator==(const NetConnection& rhs) const
@@ -61,23 +103,58 @@ namespace LimeEngine::Net
 			return !(rhs == *this);
 		}
 
+		// Only from the thread that runs the connection's event loop, NetServer::Send posts from any other thread
 		void Send(const std::string& message)
 		{
-			messagesToSend.emplace(message);
+			// Writes in flight continue with the messages queued meanwhile, only an idle connection has to be listed
+			if (messagesToSend.empty() && pendingWrites != nullptr) pendingWrites->Push(*pendingWriteLink);
+			messagesToSend.emplace_back(message);
+			queuedSendBytes += static_cast<int64_t>(message.size());
+			NetMetrics::Add(NetGauge::QueuedSendBytes, static_cast<int64_t>(message.size()));
+			if (sendWatermarks.high != 0 && !sendBlocked && queuedSendBytes >= static_cast<int64_t>(sendWatermarks.high)) { OverflowSendQueue(); }
 		}
-		bool Update()
+		// Called by event handlers once the front message is sent completely
+		void PopSentMessage()
 		{
-			while (!receivedMessages.empty())
+			int64_t messageSize = static_cast<int64_t>(messagesToSend.front().msg.size());
+			messagesToSend.pop_front();
+			queuedSendBytes -= messageSize;
+			NetMetrics::Add(NetGauge::QueuedSendBytes, -messageSize);
+			NetMetrics::Add(NetCounter::MessagesOut);
+			if (sendBlocked && queuedSendBytes <= static_cast<int64_t>(sendWatermarks.low))
 			{
-				onMessage(*this, receivedMessages.back());
-				receivedMessages.pop();
+				sendBlocked = false;
+				NotifySendPressure(false);
 			}
-			if (status == NetStatus::MarkForClose)
+		}
+		// Hands the received messages and the disconnect to the handler, returns false once the connection is closed
+		template <typename THandler>
+		bool Update(THandler& handler)
+		{
+			ready = false;
+			if (!receivedMessages.empty())
 			{
-				onDisconnect(*this);
-				status = NetStatus::Closed;
-				return false;
+				RestartIdleTimeout();
+				NetMetrics::Add(NetCounter::MessagesIn, receivedMessages.size());
 			}
+			while (!receivedMessages.empty())
+			{
+				handler.OnMessage(*this, receivedMessages.front());
+				int64_t messageSize = static_cast<int64_t>(receivedMessages.front().msg.size());
+				receivedMessages.pop();
+				queuedReceiveBytes -= messageSize;
+				NetMetrics::Add(NetGauge::QueuedReceiveBytes, -messageSize);
+			}
+			if (receiveBlocked && queuedReceiveBytes <= static_cast<int64_t>(receiveWatermarks.low)) { receiveBlocked = false; }
+			return !DispatchDisconnect(handler);
+		}
+		// Calls OnDisconnect once the connection is marked for close, returns true if it did
+		template <typename THandler>
+		bool DispatchDisconnect(THandler& handler)
+		{
+			if (status != NetStatus::MarkForClose) return false;
+			handler.OnDisconnect(*this);
+			status = NetStatus::Closed;
 			return true;
 		}
 
@@ -85,28 +162,251 @@ namespace LimeEngine::Net
 		{
 			onMessage = handler;
 		}
+		// Messages are delivered on the event loop thread as soon as they are received, without being copied or queued.
+		// A server handler with OnMessageView takes precedence.
+		void OnMessageView(const std::function<void(NetConnection&, NetMessageView)>& handler)
+		{
+			onMessageView = handler;
+		}
 		void OnDisconnect(const std::function<void(const NetConnection&)>& handler)
 		{
 			onDisconnect = handler;
 		}
+		// Called with true when the send queue reaches its high watermark and with false once it has drained.
+		// A server handler with OnSendPressure takes precedence.
+		void OnSendPressure(const std::function<void(NetConnection&, bool)>& handler)
+		{
+			onSendPressure = handler;
+		}
+
+		void SetSendWatermarks(NetWatermarks watermarks, NetSendOverflow overflow = NetSendOverflow::Notify)
+		{
+			sendWatermarks = watermarks;
+			sendOverflow = overflow;
+		}
+		// Received messages are queued until Update, the event manager stops reading the socket while the queue is blocked
+		void SetReceiveWatermarks(NetWatermarks watermarks)
+		{
+			receiveWatermarks = watermarks;
+			if (receiveBlocked && (watermarks.high == 0 || queuedReceiveBytes <= static_cast<int64_t>(watermarks.low))) { receiveBlocked = false; }
+		}
+		// Sending more while blocked still queues the message
+		bool IsSendBlocked() const noexcept
+		{
+			return sendBlocked;
+		}
+		bool IsReceiveBlocked() const noexcept
+		{
+			return receiveBlocked;
+		}
+		size_t GetQueuedSendBytes() const noexcept
+		{
+			return static_cast<size_t>(queuedSendBytes);
+		}
+		size_t GetQueuedReceiveBytes() const noexcept
+		{
+			return static_cast<size_t>(queuedReceiveBytes);
+		}
+
+		// Called by event handlers for every complete message, which waits for Update
+		void Receive(NetReceivedMessage&& message)
+		{
+			int64_t messageSize = static_cast<int64_t>(message.msg.size());
+			receivedMessages.emplace(std::move(message));
+			queuedReceiveBytes += messageSize;
+			NetMetrics::Add(NetGauge::QueuedReceiveBytes, messageSize);
+			if (receiveWatermarks.high != 0 && !receiveBlocked && queuedReceiveBytes >= static_cast<int64_t>(receiveWatermarks.high))
+			{
+				receiveBlocked = true;
+				NetMetrics::Add(NetCounter::ReadPauses);
+			}
+			MarkReady();
+		}
+		// Called by event handlers that receive in place, falls back to the message queue without a view handler
+		void ReceiveView(NetMessageView message)
+		{
+			if (viewDispatch == nullptr && !onMessageView)
+			{
+				Receive(NetReceivedMessage(std::string(message)));
+				return;
+			}
+			RestartIdleTimeout();
+			NetMetrics::Add(NetCounter::MessagesIn);
+			if (viewDispatch != nullptr) { viewDispatch(viewHandler, *this, message); }
+			else { onMessageView(*this, message); }
+		}
 
 		void ChangeStateToClose()
 		{
 			status = NetStatus::MarkForClose;
+			socket = nullptr;
+			pendingWrites = nullptr;
+			MarkReady();
+		}
+
+		// Shuts the socket down, the event manager then removes the connection as if the peer had closed it
+		void Close()
+		{
+			if (socket != nullptr) socket->Shutdown();
 		}
 
-		uint16_t GetId() const noexcept
+		// Closes the connection once nothing has been received for the timeout, zero disables it
+		void SetIdleTimeout(std::chrono::milliseconds timeout)
+		{
+			if (timers == nullptr) return;
+
+			idleTimeout = timeout;
+			if (timeout.count() <= 0)
+			{
+				timers->Cancel(std::exchange(idleTimer, 0));
+				return;
+			}
+			if (!timers->Reschedule(idleTimer, timeout))
+			{
+				idleTimer = timers->Schedule(timeout, [this]() {
+					idleTimer = 0;
+					Close();
+				});
+			}
+		}
+
+		// Timers run on the thread that handles the connection's events and are cancelled when the connection is destroyed
+		NetTimerId ScheduleTimer(std::chrono::milliseconds delay, const std::function<void(NetConnection&)>& handler)
+		{
+			if (timers == nullptr) return 0;
+			return TrackTimer(timers->Schedule(delay, [this, handler]() { handler(*this); }));
+		}
+		// Repeats until cancelled, e.g. to send heartbeats
+		NetTimerId ScheduleRepeatingTimer(std::chrono::milliseconds period, const std::function<void(NetConnection&)>& handler)
+		{
+			if (timers == nullptr) return 0;
+			return TrackTimer(timers->ScheduleRepeating(period, [this, handler]() { handler(*this); }));
+		}
+		bool CancelTimer(NetTimerId timerId)
+		{
+			return timers != nullptr && timers->Cancel(timerId);
+		}
+
+		// Set by the owner of the connection before any event is handled
+		void AttachTimers(NetTimerWheel* timerWheel) noexcept
+		{
+			timers = timerWheel;
+		}
+		void AttachSocket(NetSocket* netSocket) noexcept
+		{
+			socket = netSocket;
+		}
+		// Send lists the socket context there, so the event manager doesn't have to check every connection for messages
+		void AttachPendingWrites(NetPendingWriteList* netPendingWrites, NetPendingWriteLink* link) noexcept
+		{
+			pendingWrites = netPendingWrites;
+			pendingWriteLink = link;
+		}
+		// Receive and ChangeStateToClose list the connection there, so Update doesn't have to visit idle connections
+		void AttachReadyList(NetReadyList* netReadyList) noexcept
+		{
+			readyList = netReadyList;
+		}
+		void AttachViewHandler(void* handler, NetMessageViewDispatch dispatch) noexcept
+		{
+			viewHandler = handler;
+			viewDispatch = dispatch;
+		}
+		void AttachSendPressureHandler(void* handler, NetSendPressureDispatch dispatch) noexcept
+		{
+			sendPressureHandler = handler;
+			sendPressureDispatch = dispatch;
+		}
+
+		NetConnectionId GetId() const noexcept
 		{
 			return Id;
 		}
 
-		std::queue<NetSendMessage> messagesToSend;
+		// Event handlers may send several queued messages at once
+		std::deque<NetSendMessage> messagesToSend;
 		std::queue<NetReceivedMessage> receivedMessages;
 
 	private:
+		void OverflowSendQueue()
+		{
+			NetMetrics::Add(NetCounter::SendOverflows);
+			if (sendOverflow == NetSendOverflow::Close)
+			{
+				Close();
+				return;
+			}
+			sendBlocked = true;
+			NotifySendPressure(true);
+		}
+		void NotifySendPressure(bool blocked)
+		{
+			if (sendPressureDispatch != nullptr) { sendPressureDispatch(sendPressureHandler, *this, blocked); }
+			else if (onSendPressure) { onSendPressure(*this, blocked); }
+		}
+
+		void MarkReady()
+		{
+			if (ready || readyList == nullptr) return;
+			ready = true;
+			readyList->Push(Id);
+		}
+
+		void RestartIdleTimeout()
+		{
+			if (idleTimer != 0) timers->Reschedule(idleTimer, idleTimeout);
+		}
+
+		NetTimerId TrackTimer(NetTimerId timerId)
+		{
+			// Ids of fired one-shot timers are dropped once in a while so the list doesn't grow
+			if (ownedTimers.size() >= 16 && ownedTimers.size() == ownedTimers.capacity())
+			{
+				std::erase_if(ownedTimers, [this](NetTimerId id) { return !timers->Contains(id); });
+			}
+			ownedTimers.push_back(timerId);
+			return timerId;
+		}
+
+		void CancelTimers()
+		{
+			if (timers == nullptr) return;
+			timers->Cancel(idleTimer);
+			for (NetTimerId timerId : ownedTimers)
+			{
+				timers->Cancel(timerId);
+			}
+		}
+
+	private:
+		friend class NetFunctionHandler;
+
 		std::function<void(const NetConnection&, const NetReceivedMessage&)> onMessage;
+		std::function<void(NetConnection&, NetMessageView)> onMessageView;
 		std::function<void(const NetConnection&)> onDisconnect;
+		std::function<void(NetConnection&, bool)> onSendPressure;
 		NetStatus status = NetStatus::Init;
-		uint16_t Id;
+		NetConnectionId Id;
+
+		NetReadyList* readyList = nullptr;
+		bool ready = false;
+		void* viewHandler = nullptr;
+		NetMessageViewDispatch viewDispatch = nullptr;
+		void* sendPressureHandler = nullptr;
+		NetSendPressureDispatch sendPressureDispatch = nullptr;
+		NetSocket* socket = nullptr;
+		NetPendingWriteList* pendingWrites = nullptr;
+		NetPendingWriteLink* pendingWriteLink = nullptr;
+		NetTimerWheel* timers = nullptr;
+		NetTimerId idleTimer = 0;
+		std::chrono::milliseconds idleTimeout{ 0 };
+		std::vector<NetTimerId> ownedTimers;
+		int64_t queuedSendBytes = 0;
+		int64_t queuedReceiveBytes = 0;
+		NetWatermarks sendWatermarks;
+		NetWatermarks receiveWatermarks;
+		NetSendOverflow sendOverflow = NetSendOverflow::Notify;
+		bool sendBlocked = false;
+		bool receiveBlocked = false;
 	};
 }
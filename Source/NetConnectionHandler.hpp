@@ -0,0 +1,72 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <concepts>
+#include <functional>
+#include "NetConnection.hpp"
+
+namespace LimeEngine::Net
+{
+	// Connection events of a NetServer, dispatched through the handler's static type so the calls can be inlined into the worker loops.
+	// One handler is shared by every worker, with threads it is called from each of them.
+	template <typename THandler>
+	concept NetConnectionHandler = requires(THandler& handler, NetConnection& connection, const NetReceivedMessage& message) {
+		handler.OnConnection(connection);
+		handler.OnMessage(connection, message);
+		handler.OnDisconnect(connection);
+	};
+
+	// Optional, receives the messages of event handlers that receive in place (see NetConnection::ReceiveView)
+	template <typename THandler>
+	concept NetMessageViewHandler = requires(THandler& handler, NetConnection& connection, NetMessageView message) {
+		handler.OnMessageView(connection, message);
+	};
+
+	// Optional, told when a connection's send queue reaches its high watermark and when it drains (see NetConnection::SetSendWatermarks)
+	template <typename THandler>
+	concept NetSendPressureHandler = requires(THandler& handler, NetConnection& connection, bool blocked) {
+		handler.OnSendPressure(connection, blocked);
+	};
+
+	// Empty defaults, a handler derived from it only declares the events it needs
+	class NetConnectionHandlerBase
+	{
+	public:
+		void OnConnection(NetConnection&) {}
+		void OnMessage(NetConnection&, const NetReceivedMessage&) {}
+		void OnDisconnect(NetConnection&) {}
+	};
+
+	// Adapter for std::function callbacks: NetServer::OnConnection for the server, NetConnection::OnMessage/OnMessageView/OnDisconnect per connection
+	class NetFunctionHandler
+	{
+	public:
+		void OnConnection(NetConnection& connection)
+		{
+			if (onConnection) onConnection(connection);
+		}
+		void OnMessage(NetConnection& connection, const NetReceivedMessage& message)
+		{
+			if (connection.onMessage) connection.onMessage(connection, message);
+		}
+		void OnDisconnect(NetConnection& connection)
+		{
+			if (connection.onDisconnect) connection.onDisconnect(connection);
+		}
+
+	public:
+		std::function<void(NetConnection&)> onConnection;
+	};
+
+	template <typename THandler>
+	void DispatchMessageView(void* handler, NetConnection& connection, NetMessageView message)
+	{
+		static_cast<THandler*>(handler)->OnMessageView(connection, message);
+	}
+	template <typename THandler>
+	void DispatchSendPressure(void* handler, NetConnection& connection, bool blocked)
+	{
+		static_cast<THandler*>(handler)->OnSendPressure(connection, blocked);
+	}
+}
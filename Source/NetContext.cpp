@@ -7,11 +7,13 @@ namespace LimeEngine::Net
 {
 	IOContext::IOContext(IOOperationType operationType) noexcept : operationType(operationType), netBuffer(0, nullptr)
 	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		nativeIoContext.Internal = 0;
 		nativeIoContext.InternalHigh = 0;
 		nativeIoContext.Offset = 0;
 		nativeIoContext.OffsetHigh = 0;
 		nativeIoContext.hEvent = nullptr;
+#endif
 	}
 
 	void IOContext::SetNextBuffer(const char* buffer)
@@ -30,9 +32,17 @@ namespace LimeEngine::Net
 		netBuffer.len = messageLen;
 	}
 
+	void IOContext::SetNetBuffers(NetBuffer* buffers, uint32_t bufferCount)
+	{
+		netBuffers = buffers;
+		netBufferCount = bufferCount;
+	}
+
 	void IOContext::Reset()
 	{
 		buffers.clear();
+		netBuffers = nullptr;
+		netBufferCount = 0;
 	}
 
 	std::pair<char*, uint32_t> IOContext::GetBuffer() const
@@ -45,8 +55,23 @@ namespace LimeEngine::Net
 		return buffers;
 	}
 
+	NetBuffer* IOContext::GetNetBuffers() noexcept
+	{
+		return (netBuffers != nullptr) ? netBuffers : &netBuffer;
+	}
+
+	uint32_t IOContext::GetNetBufferCount() const noexcept
+	{
+		return (netBuffers != nullptr) ? netBufferCount : 1u;
+	}
+
 	IOContext* IOContext::FromNativeIoContext(NativeIOContext* nativeIoContext) noexcept
 	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		return CONTAINING_RECORD(nativeIoContext, IOContext, nativeIoContext);
+#else
+		// nativeIoContext is the first member
+		return reinterpret_cast<IOContext*>(nativeIoContext);
+#endif
 	}
 }
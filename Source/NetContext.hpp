@@ -4,6 +4,9 @@
 #pragma once
 #include "NetConnection.hpp"
 #include "NetSockets.hpp"
+#include "NetReceiveRing.hpp"
+#include "NetSendBatch.hpp"
+#include "NetPendingWriteList.hpp"
 
 namespace LimeEngine::Net
 {
@@ -21,10 +24,14 @@ namespace LimeEngine::Net
 		void SetNextBuffer(const char* buffer);
 		void SetNextBuffer(char* buffer);
 		void SetMessageLength(uint32_t messageLen);
+		// Several buffers submitted by one vectored call instead of netBuffer
+		void SetNetBuffers(NetBuffer* buffers, uint32_t bufferCount);
 		void Reset();
 
 		std::pair<char*, uint32_t> GetBuffer() const;
 		const std::list<char*>& GetBuffers() const;
+		NetBuffer* GetNetBuffers() noexcept;
+		uint32_t GetNetBufferCount() const noexcept;
 
 		static IOContext* FromNativeIoContext(NativeIOContext* nativeIoContext) noexcept;
 
@@ -35,16 +42,31 @@ namespace LimeEngine::Net
 		NetBuffer netBuffer;
 		std::list<char*> buffers;
 		IOOperationType operationType = IOOperationType::Receive;
+
+	private:
+		NetBuffer* netBuffers = nullptr;
+		uint32_t netBufferCount = 0;
 	};
 
 	class SocketContext
 	{
 	public:
-		SocketContext(NetSocket&& socket, NetConnection* connection) : socket(std::move(socket)), connection(connection) {}
+		SocketContext(NetSocket&& socket, NetConnection* connection) : socket(std::move(socket)), connection(connection)
+		{
+			connection->AttachSocket(&this->socket);
+		}
 
 		NetSocket socket;
 		NetConnection* connection;
+		// Position in the event manager's context list, kept up to date by swap-and-pop removal
+		size_t index = 0;
+		// Set while the connection's receive queue is blocked and the event manager has stopped reading the socket
+		bool readPaused = false;
 		IOContext receiveContext{ IOOperationType::Receive };
 		IOContext sendContext{ IOOperationType::Send };
+		NetFrameDecoder frameDecoder;
+		NetReceiveRing receiveRing;
+		NetSendBatch sendBatch;
+		NetPendingWriteLink pendingWrite{ this };
 	};
 }
\ No newline at end of file
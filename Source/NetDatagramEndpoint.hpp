@@ -0,0 +1,288 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include "NetSockets.hpp"
+#include "NetConnection.hpp"
+#include "NetMetrics.hpp"
+#include "NetWaitStrategy.hpp"
+#include "Protocols/NetProtocolUDP.hpp"
+
+namespace LimeEngine::Net
+{
+	// Plain function pointer into the endpoint that owns a peer, so peers don't depend on the endpoint's template arguments
+	using NetDatagramSendDispatch = bool (*)(void* endpoint, const NetSocketIPv4Address& peer, NetMessageView message);
+
+	// Address a datagram came from, kept until it is removed
+	class NetPeer
+	{
+	public:
+		NetPeer(NetSocketIPv4Address address, void* endpoint, NetDatagramSendDispatch sendDispatch) noexcept :
+			address(address), endpoint(endpoint), sendDispatch(sendDispatch)
+		{}
+
+		// Queued on the endpoint that received the peer's datagrams, see NetDatagramEndpoint::Send
+		bool Send(NetMessageView message)
+		{
+			return sendDispatch(endpoint, address, message);
+		}
+
+	public:
+		NetSocketIPv4Address address;
+		std::chrono::steady_clock::time_point lastReceive;
+		uint64_t datagramsIn = 0;
+
+	private:
+		void* endpoint;
+		NetDatagramSendDispatch sendDispatch;
+	};
+
+	// Datagram events of a NetDatagramEndpoint, dispatched through the handler's static type like NetConnectionHandler.
+	// The message points into a receive buffer that is reused by the next batch.
+	template <typename THandler>
+	concept NetDatagramHandler = requires(THandler& handler, NetPeer& peer, NetMessageView message) {
+		handler.OnDatagram(peer, message);
+	};
+
+	// Optional, called before the first datagram of an address that isn't a peer yet
+	template <typename THandler>
+	concept NetPeerHandler = requires(THandler& handler, NetPeer& peer) {
+		handler.OnPeer(peer);
+	};
+
+	// One UDP socket serving every peer. A batch of datagrams is received with one call into buffers of the pool and dispatched
+	// per peer address, sends are copied into pool buffers and go out batched at the end of HandleNetEvents.
+	template <NetDatagramHandler THandler, size_t BufferSize = 2048, typename TNetProtocol = NetProtocolUDP>
+	class NetDatagramEndpoint
+	{
+	private:
+		static constexpr uint32_t batchSize = NetSocket::maxDatagramBatch;
+		// Batches received per HandleNetEvents, the rest waits for the next call so sends aren't starved
+		static constexpr uint32_t maxReceiveBatches = 16;
+		// IPv4 UDP payload limit
+		static constexpr uint32_t maxDatagramSize = 65507;
+
+	public:
+		NetDatagramEndpoint(const NetDatagramEndpoint& other) = delete;
+		NetDatagramEndpoint operator=(const NetDatagramEndpoint& other) = delete;
+
+		explicit NetDatagramEndpoint(NetSocketIPv4Address address, THandler handler = THandler()) :
+			socket(NetAddressType::IPv4, NetSocketType::Datagram), handler(std::move(handler)), bufferPool(batchSize * 2)
+		{
+			socket.SetNonblockingMode();
+			socket.Bind(address);
+			for (auto& datagram : receiveBatch)
+			{
+				datagram.buf = bufferPool.TakeBuffer();
+			}
+		}
+		~NetDatagramEndpoint()
+		{
+			for (auto& datagram : receiveBatch)
+			{
+				bufferPool.ReturnBuffer(datagram.buf);
+			}
+			for (size_t i = sendOffset; i < pendingSends.size(); ++i)
+			{
+				bufferPool.ReturnBuffer(pendingSends[i].buf);
+			}
+		}
+
+	public:
+		// Queued until the next Flush, false if the message doesn't fit a buffer (see SendSegmented)
+		bool Send(const NetSocketIPv4Address& peer, NetMessageView message)
+		{
+			if (message.size() > BufferSize)
+			{
+				LENET_LOG_DEBUG(IO, "Datagram of {}b doesn't fit a {}b buffer", message.size(), BufferSize);
+				return false;
+			}
+			char* buf = bufferPool.TakeBuffer();
+			std::memcpy(buf, message.data(), message.size());
+			pendingSends.push_back(NetDatagram{ peer, buf, static_cast<uint32_t>(message.size()) });
+			return true;
+		}
+
+		// Splits the message into datagrams of segmentSize bytes for one peer. Where UDP_SEGMENT is supported the kernel does the split,
+		// up to NetSocket::maxSegments datagrams per call, otherwise the segments are queued like Send.
+		void SendSegmented(const NetSocketIPv4Address& peer, NetMessageView message, uint16_t segmentSize)
+		{
+			if (segmentSize == 0 || segmentSize > BufferSize)
+			{
+				LENET_LOG_DEBUG(IO, "Segment size {} doesn't fit a {}b buffer", segmentSize, BufferSize);
+				return;
+			}
+			// Datagrams queued earlier go out first
+			Flush();
+			const size_t maxChunk = std::min<size_t>(NetSocket::maxSegments * segmentSize, maxDatagramSize / segmentSize * segmentSize);
+			while (!message.empty())
+			{
+				NetMessageView chunk = message.substr(0, maxChunk);
+				if (!SendChunk(peer, chunk, segmentSize))
+				{
+					for (size_t offset = 0; offset < chunk.size(); offset += segmentSize)
+					{
+						Send(peer, chunk.substr(offset, segmentSize));
+					}
+				}
+				message.remove_prefix(chunk.size());
+			}
+		}
+
+		// Sends the queued datagrams, those that don't fit the socket's send buffer stay queued
+		void Flush()
+		{
+			while (sendOffset < pendingSends.size())
+			{
+				uint32_t count = static_cast<uint32_t>(std::min<size_t>(pendingSends.size() - sendOffset, batchSize));
+				uint32_t sentCount;
+				NetMetrics::Add(NetCounter::Syscalls);
+				if (!TNetProtocol::SendBatch(socket, pendingSends.data() + sendOffset, count, sentCount)) break;
+
+				for (uint32_t i = 0; i < sentCount; ++i)
+				{
+					NetMetrics::Add(NetCounter::BytesOut, pendingSends[sendOffset + i].len);
+					bufferPool.ReturnBuffer(pendingSends[sendOffset + i].buf);
+				}
+				NetMetrics::Add(NetCounter::MessagesOut, sentCount);
+				sendOffset += sentCount;
+			}
+			if (sendOffset == pendingSends.size())
+			{
+				pendingSends.clear();
+				sendOffset = 0;
+			}
+		}
+
+		// Returns whether a datagram arrived, so it can be driven by a NetWaitStrategy
+		bool HandleNetEvents(uint32_t timeout = 100u)
+		{
+			Flush();
+
+			bool readable = TimedWait(timeout, [&]() { return socket.WaitForRead(timeout); });
+			NetMetrics::Add(NetCounter::Syscalls);
+			NetMetrics::Add(NetCounter::Wakeups);
+			if (!readable)
+			{
+				NetMetrics::Add(NetCounter::EmptyWakeups);
+				return false;
+			}
+
+			for (uint32_t batch = 0; batch < maxReceiveBatches; ++batch)
+			{
+				uint32_t count;
+				NetMetrics::Add(NetCounter::Syscalls);
+				if (!TNetProtocol::ReceiveBatch(socket, receiveBatch.data(), batchSize, BufferSize, count)) break;
+				Dispatch(count);
+				if (count < batchSize) break;
+			}
+			// Replies of the handler go out in the same round
+			Flush();
+			return true;
+		}
+
+		// Not to be called from the handler, the peer it is given would dangle
+		bool RemovePeer(const NetSocketIPv4Address& address)
+		{
+			return peers.erase(address.GetKey()) != 0;
+		}
+		// Removes peers that sent nothing for the given time, returns how many
+		size_t RemoveIdlePeers(std::chrono::steady_clock::duration idleTimeout)
+		{
+			auto deadline = std::chrono::steady_clock::now() - idleTimeout;
+			return std::erase_if(peers, [deadline](const auto& entry) { return entry.second.lastReceive < deadline; });
+		}
+		NetPeer* FindPeer(const NetSocketIPv4Address& address)
+		{
+			auto it = peers.find(address.GetKey());
+			return it != peers.end() ? &it->second : nullptr;
+		}
+		size_t NumberOfPeers() const noexcept
+		{
+			return peers.size();
+		}
+		size_t NumberOfQueuedSends() const noexcept
+		{
+			return pendingSends.size() - sendOffset;
+		}
+
+		THandler& GetHandler() noexcept
+		{
+			return handler;
+		}
+		NetSocket& GetSocket() noexcept
+		{
+			return socket;
+		}
+
+	private:
+		void Dispatch(uint32_t count)
+		{
+			auto now = std::chrono::steady_clock::now();
+			uint32_t dispatchedCount = 0;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				NetDatagram& datagram = receiveBatch[i];
+				if (datagram.truncated)
+				{
+					LENET_LOG_DEBUG(IO, "Dropped datagram from {} larger than {}b", datagram.peer.ToString(), BufferSize);
+					NetMetrics::Add(NetCounter::DroppedDatagrams);
+					continue;
+				}
+				NetMetrics::Add(NetCounter::BytesIn, datagram.len);
+
+				auto [it, inserted] = peers.try_emplace(datagram.peer.GetKey(), datagram.peer, this, &DispatchSend);
+				NetPeer& peer = it->second;
+				peer.lastReceive = now;
+				++peer.datagramsIn;
+				if constexpr (NetPeerHandler<THandler>)
+				{
+					if (inserted) handler.OnPeer(peer);
+				}
+				handler.OnDatagram(peer, NetMessageView(datagram.buf, datagram.len));
+				++dispatchedCount;
+			}
+			NetMetrics::Add(NetCounter::MessagesIn, dispatchedCount);
+		}
+
+		static bool DispatchSend(void* endpoint, const NetSocketIPv4Address& peer, NetMessageView message)
+		{
+			return static_cast<NetDatagramEndpoint*>(endpoint)->Send(peer, message);
+		}
+
+		// False if the chunk has to be sent as separate datagrams
+		bool SendChunk(const NetSocketIPv4Address& peer, NetMessageView chunk, uint16_t segmentSize)
+		{
+			if (!segmentationSupported || chunk.size() <= segmentSize) return false;
+
+			int bytesTransferred;
+			NetMetrics::Add(NetCounter::Syscalls);
+			if (TNetProtocol::SendSegments(socket, peer, chunk.data(), static_cast<uint32_t>(chunk.size()), segmentSize, bytesTransferred))
+			{
+				size_t segmentCount = (chunk.size() + segmentSize - 1) / segmentSize;
+				NetMetrics::Add(NetCounter::BytesOut, chunk.size());
+				NetMetrics::Add(NetCounter::MessagesOut, segmentCount);
+				return true;
+			}
+			// Unsupported stays unsupported for this socket, a full send buffer only for this chunk
+			if (bytesTransferred == 0) segmentationSupported = false;
+			return false;
+		}
+
+	private:
+		NetSocket socket;
+		THandler handler;
+		BufferPool<BufferSize> bufferPool;
+		std::array<NetDatagram, batchSize> receiveBatch;
+		// Sent from sendOffset on, so a partial batch doesn't move the rest
+		std::vector<NetDatagram> pendingSends;
+		size_t sendOffset = 0;
+		std::unordered_map<uint64_t, NetPeer> peers;
+		bool segmentationSupported = true;
+	};
+}
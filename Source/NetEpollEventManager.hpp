@@ -0,0 +1,256 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include "NetBufferBasedEventManager.hpp"
+#include "NetWakeup.hpp"
+
+#ifdef LE_BUILD_PLATFORM_LINUX
+	#include <sys/epoll.h>
+	#include <unistd.h>
+
+namespace LimeEngine::Net
+{
+	enum class NetEpollTrigger
+	{
+		Level,
+		Edge
+	};
+
+	template <NetEpollTrigger Trigger>
+	class NetEpollBuffer;
+
+	template <typename TNetDataHandler, typename TNetEventHandler = NetEventHandler, NetEpollTrigger Trigger = NetEpollTrigger::Level>
+	using NetEpollEventManager = NetBufferBasedEventManager<NetEpollBuffer<Trigger>, TNetDataHandler, TNetEventHandler>;
+
+	struct EpollFD
+	{
+		explicit EpollFD(uint32_t events) : events(events) {}
+
+		bool CheckRead() const
+		{
+			return events & EPOLLIN;
+		}
+		bool CheckWrite() const
+		{
+			return events & EPOLLOUT;
+		}
+		bool CheckExcept() const
+		{
+			return events & EPOLLERR;
+		}
+		bool CheckDisconnect() const
+		{
+			return events & EPOLLHUP;
+		}
+		bool IsChanged() const
+		{
+			return events != 0;
+		}
+
+	private:
+		uint32_t events;
+	};
+
+	template <NetEpollTrigger Trigger = NetEpollTrigger::Level>
+	class NetEpollBuffer
+	{
+	private:
+		struct EpollSocket
+		{
+			NativeSocket fd;
+			bool readFlag = true;
+			bool writeFlag = false;
+		};
+
+		static constexpr uint32_t triggerEvents = (Trigger == NetEpollTrigger::Edge) ? EPOLLET : 0u;
+		static constexpr uint32_t readEvents = triggerEvents | EPOLLIN;
+		static constexpr size_t maxEventsPerWait = 1024;
+
+	public:
+		static constexpr bool edgeTriggered = Trigger == NetEpollTrigger::Edge;
+
+		NetEpollBuffer(const NetEpollBuffer&) = delete;
+		NetEpollBuffer& operator=(const NetEpollBuffer&) = delete;
+
+		NetEpollBuffer(NetEpollBuffer&& other) noexcept :
+			epollFD(other.epollFD), wakeup(std::move(other.wakeup)), sockets(std::move(other.sockets)), socketIndices(std::move(other.socketIndices)), events(std::move(other.events)),
+			readyCount(other.readyCount)
+		{
+			other.epollFD = InvalidNativeSocket;
+			other.readyCount = 0;
+		}
+		NetEpollBuffer& operator=(NetEpollBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Close();
+				epollFD = other.epollFD;
+				wakeup = std::move(other.wakeup);
+				sockets = std::move(other.sockets);
+				socketIndices = std::move(other.socketIndices);
+				events = std::move(other.events);
+				readyCount = other.readyCount;
+				other.epollFD = InvalidNativeSocket;
+				other.readyCount = 0;
+			}
+			return *this;
+		}
+
+		NetEpollBuffer() : epollFD(epoll_create1(EPOLL_CLOEXEC)), events(maxEventsPerWait)
+		{
+			if (epollFD == InvalidNativeSocket) { LENET_LAST_ERROR_MSG("Can't create epoll"); }
+			if (!Control(EPOLL_CTL_ADD, wakeup.GetNativeHandle(), EPOLLIN)) { LENET_LAST_ERROR_MSG("Can't add wakeup to epoll"); }
+		}
+		~NetEpollBuffer()
+		{
+			Close();
+		}
+
+		bool Add(NativeSocket fd)
+		{
+			if (!Control(EPOLL_CTL_ADD, fd, readEvents))
+			{
+				LENET_LAST_ERROR_MSG("Can't add socket to epoll");
+				return false;
+			}
+
+			if (static_cast<size_t>(fd) >= socketIndices.size()) { socketIndices.resize(fd + 1ull); }
+			socketIndices[fd] = sockets.size();
+			sockets.emplace_back(fd);
+			return true;
+		}
+		void Remove(size_t index)
+		{
+			NativeSocket fd = sockets[index].fd;
+			if (!Control(EPOLL_CTL_DEL, fd, 0)) { LENET_LAST_ERROR_MSG("Can't remove socket from epoll"); }
+
+			// The last socket takes the place of the removed one
+			sockets[index] = sockets.back();
+			socketIndices[sockets[index].fd] = index;
+			sockets.pop_back();
+		}
+
+		int WaitForEvents(uint32_t timeout)
+		{
+			readyCount = 0;
+			int result = epoll_wait(epollFD, events.data(), static_cast<int>(events.size()), static_cast<int>(timeout));
+			if (result < 0)
+			{
+				if (errno == EINTR) return 0;
+				LENET_LAST_ERROR_MSG("Can't to wait for epoll events");
+				return 0;
+			}
+			// The wakeup isn't a socket, the last ready event takes its place
+			for (int i = 0; i < result; ++i)
+			{
+				if (events[i].data.fd != wakeup.GetNativeHandle()) continue;
+				wakeup.Drain();
+				events[i] = events[--result];
+				break;
+			}
+			readyCount = static_cast<size_t>(result);
+			return result;
+		}
+
+		// Any thread, interrupts the current or the next wait
+		void Wake()
+		{
+			wakeup.Signal();
+		}
+
+		void SetReadFlag(size_t index)
+		{
+			SetInterest(sockets[index], true, sockets[index].writeFlag);
+		}
+		void ResetReadFlag(size_t index)
+		{
+			SetInterest(sockets[index], false, sockets[index].writeFlag);
+		}
+		void SetWriteFlag(size_t index)
+		{
+			SetInterest(sockets[index], sockets[index].readFlag, true);
+		}
+		void ResetWriteFlag(size_t index)
+		{
+			SetInterest(sockets[index], sockets[index].readFlag, false);
+		}
+
+		size_t Count() const
+		{
+			return sockets.size();
+		}
+		bool Empty() const
+		{
+			return sockets.empty();
+		}
+
+		// Only sockets with pending events are visited after a wait
+		size_t EventsCount() const
+		{
+			return readyCount;
+		}
+		size_t EventSocketIndex(size_t eventIndex) const
+		{
+			return socketIndices[events[eventIndex].data.fd];
+		}
+		EpollFD EventAt(size_t eventIndex) const
+		{
+			return EpollFD(events[eventIndex].events);
+		}
+
+		void Log() const
+		{
+			std::ostringstream oss;
+			oss << "[Epoll] Ready:";
+			for (size_t i = 0; i < readyCount; ++i)
+			{
+				const epoll_event& event = events[i];
+				oss << '[' << event.data.fd << ':';
+				oss << ((event.events & EPOLLIN) ? "R" : "");
+				oss << ((event.events & EPOLLOUT) ? "W" : "");
+				oss << ((event.events & EPOLLERR) ? "E" : "");
+				oss << ((event.events & EPOLLHUP) ? "D" : "");
+				oss << ']';
+			}
+			LENET_LOG_TRACE(Poll, oss.str());
+		}
+
+	private:
+		// Hangups and errors are reported regardless of the interest
+		void SetInterest(EpollSocket& socket, bool read, bool write)
+		{
+			if (socket.readFlag == read && socket.writeFlag == write) return;
+			uint32_t flags = triggerEvents | (read ? EPOLLIN : 0u) | (write ? EPOLLOUT : 0u);
+			if (!Control(EPOLL_CTL_MOD, socket.fd, flags)) { LENET_LAST_ERROR_MSG("Can't change epoll interest"); }
+			socket.readFlag = read;
+			socket.writeFlag = write;
+		}
+
+		bool Control(int operation, NativeSocket fd, uint32_t flags)
+		{
+			epoll_event event{};
+			event.events = flags;
+			event.data.fd = fd;
+			return epoll_ctl(epollFD, operation, fd, &event) == 0;
+		}
+
+		void Close()
+		{
+			if (epollFD != InvalidNativeSocket)
+			{
+				close(epollFD);
+				epollFD = InvalidNativeSocket;
+			}
+		}
+
+	private:
+		NativeSocket epollFD = InvalidNativeSocket;
+		NetWakeup wakeup;
+		std::vector<EpollSocket> sockets;
+		std::vector<size_t> socketIndices;
+		std::vector<epoll_event> events;
+		size_t readyCount = 0;
+	};
+}
+#endif
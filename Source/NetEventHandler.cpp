@@ -5,6 +5,8 @@
 
 namespace LimeEngine::Net
 {
+	NetEventHandler::NetEventHandler(const SlabOptions& slabOptions) : bufferPool(slabOptions) {}
+
 	void NetEventHandler::StartRead(SocketContext& socketContext)
 	{
 		socketContext.receiveContext.SetMessageLength(bufferPool.size);
@@ -16,14 +18,14 @@ namespace LimeEngine::Net
 		IOContext& ioContext = socketContext.receiveContext;
 		auto [buffer, size] = ioContext.GetBuffer();
 
-		NetLogger::LogCore("Read: {}", buffer);
+		LENET_LOG_TRACE(IO, "Read: {}", buffer);
 
 		if (buffer[bytesTransferred - 1] == '\0')
 		{
 			NetReceivedMessage fullMsg = NetReceivedMessage(ConcatBuffers(ioContext.GetBuffers(), bufferPool.size));
-			socketContext.connection->receivedMessages.emplace(std::move(fullMsg));
+			socketContext.connection->Receive(std::move(fullMsg));
 
-			NetLogger::LogCore("[msg end]");
+			LENET_LOG_DEBUG(IO, "[msg end]");
 
 			bufferPool.ReturnBuffers(ioContext.GetBuffers());
 			ioContext.Reset();
@@ -31,11 +33,28 @@ namespace LimeEngine::Net
 		ioContext.SetNextBuffer(bufferPool.TakeBuffer());
 	}
 
+	void NetEventHandler::ReadProvided(SocketContext& socketContext, char* buffer, uint32_t bytesTransferred)
+	{
+		IOContext& ioContext = socketContext.receiveContext;
+		ioContext.SetNextBuffer(buffer);
+
+		if (buffer[bytesTransferred - 1] == '\0')
+		{
+			NetReceivedMessage fullMsg = NetReceivedMessage(ConcatBuffers(ioContext.GetBuffers(), bufferPool.size));
+			socketContext.connection->Receive(std::move(fullMsg));
+
+			LENET_LOG_DEBUG(IO, "[msg end]");
+
+			bufferPool.ReturnBuffers(ioContext.GetBuffers());
+			ioContext.Reset();
+		}
+	}
+
 	bool NetEventHandler::StartWrite(SocketContext& socketContext)
 	{
 		if (!socketContext.connection->messagesToSend.empty())
 		{
-			auto& sendMsg = socketContext.connection->messagesToSend.back();
+			auto& sendMsg = socketContext.connection->messagesToSend.front();
 			if (sendMsg.sended) return false;
 
 			socketContext.sendContext.SetMessageLength(sendMsg.msg.length() + 1);
@@ -48,14 +67,23 @@ namespace LimeEngine::Net
 
 	bool NetEventHandler::Write(SocketContext& socketContext, uint32_t bytesTransferred)
 	{
-		socketContext.connection->messagesToSend.pop();
+		// A non-blocking socket may take only a part of the message, the rest is sent by the next call
+		NetBuffer& netBuffer = socketContext.sendContext.netBuffer;
+		if (bytesTransferred < netBuffer.len)
+		{
+			netBuffer.buf += bytesTransferred;
+			netBuffer.len -= bytesTransferred;
+			return true;
+		}
+
+		socketContext.connection->PopSentMessage();
 		socketContext.sendContext.Reset();
 		return StartWrite(socketContext);
 	}
 
 	bool NetEventHandler::ReadyToWrite(SocketContext& socketContext)
 	{
-		NetLogger::LogCore("ReadyToWrite {}", !socketContext.connection->messagesToSend.empty());
+		LENET_LOG_TRACE(IO, "ReadyToWrite {}", !socketContext.connection->messagesToSend.empty());
 		return !socketContext.connection->messagesToSend.empty();
 	}
 
@@ -64,4 +92,9 @@ namespace LimeEngine::Net
 		socketContext.connection->ChangeStateToClose();
 		return true;
 	}
-}
\ No newline at end of file
+
+	BufferPool<1024>& NetEventHandler::GetBufferPool() noexcept
+	{
+		return bufferPool;
+	}
+}
@@ -9,9 +9,15 @@ namespace LimeEngine::Net
 {
 	class NetEventHandler
 	{
+	public:
+		NetEventHandler() = default;
+		// Receive buffers are carved out of slabs instead of one heap node per buffer, see BufferPool(const SlabOptions&)
+		explicit NetEventHandler(const SlabOptions& slabOptions);
+
 	public:
 		void StartRead(SocketContext& socketContext);
 		void Read(SocketContext& socketContext, uint32_t bytesTransferred);
+		void ReadProvided(SocketContext& socketContext, char* buffer, uint32_t bytesTransferred);
 
 		bool StartWrite(SocketContext& socketContext);
 		bool Write(SocketContext& socketContext, uint32_t bytesTransferred);
@@ -19,6 +25,8 @@ namespace LimeEngine::Net
 		bool ReadyToWrite(SocketContext& socketContext);
 		bool Disconnect(SocketContext& socketContext);
 
+		BufferPool<1024>& GetBufferPool() noexcept;
+
 	private:
 		BufferPool<1024> bufferPool;
 	};
@@ -0,0 +1,104 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetFramedEventHandler.hpp"
+
+namespace LimeEngine::Net
+{
+	NetFramedEventHandler::NetFramedEventHandler(const SlabOptions& slabOptions) : bufferPool(slabOptions) {}
+
+	void NetFramedEventHandler::StartRead(SocketContext& socketContext)
+	{
+		socketContext.receiveContext.SetMessageLength(bufferPool.size);
+		socketContext.receiveContext.SetNextBuffer(bufferPool.TakeBuffer());
+	}
+
+	void NetFramedEventHandler::Read(SocketContext& socketContext, uint32_t bytesTransferred)
+	{
+		// The same buffer is reused for the next receive
+		Decode(socketContext, socketContext.receiveContext.netBuffer.buf, bytesTransferred);
+	}
+
+	void NetFramedEventHandler::ReadProvided(SocketContext& socketContext, char* buffer, uint32_t bytesTransferred)
+	{
+		Decode(socketContext, buffer, bytesTransferred);
+		bufferPool.ReturnBuffer(buffer);
+	}
+
+	void NetFramedEventHandler::Decode(SocketContext& socketContext, const char* buffer, uint32_t bytesTransferred)
+	{
+		NetConnection& connection = *socketContext.connection;
+		bool isValid = socketContext.frameDecoder.Feed(buffer, bytesTransferred, [&connection](std::string&& message) {
+			connection.Receive(NetReceivedMessage(std::move(message)));
+			LENET_LOG_DEBUG(IO, "[msg end]");
+		}, maxMessageSize);
+		// The next receive then reports the disconnect and the event manager removes the connection
+		if (!isValid) { socketContext.socket.Shutdown(); }
+	}
+
+	bool NetFramedEventHandler::StartWrite(SocketContext& socketContext)
+	{
+		// A batch in flight is continued by Write
+		NetSendBatch& sendBatch = socketContext.sendBatch;
+		if (!sendBatch.Empty()) return false;
+
+		for (auto& sendMsg : socketContext.connection->messagesToSend)
+		{
+			if (sendBatch.Full()) break;
+			sendBatch.AddFramed(sendMsg.msg);
+			sendMsg.sended = true;
+		}
+		if (sendBatch.Empty()) return false;
+
+		socketContext.sendContext.SetNetBuffers(sendBatch.Buffers(), sendBatch.BufferCount());
+		return true;
+	}
+
+	bool NetFramedEventHandler::Write(SocketContext& socketContext, uint32_t bytesTransferred)
+	{
+		// Partial sends resume inside the batch, the stream would be corrupted otherwise
+		NetSendBatch& sendBatch = socketContext.sendBatch;
+		for (size_t sentMessages = sendBatch.Advance(bytesTransferred); sentMessages != 0; --sentMessages)
+		{
+			socketContext.connection->PopSentMessage();
+		}
+
+		if (!sendBatch.Empty())
+		{
+			socketContext.sendContext.SetNetBuffers(sendBatch.Buffers(), sendBatch.BufferCount());
+			return true;
+		}
+		socketContext.sendContext.Reset();
+		return StartWrite(socketContext);
+	}
+
+	bool NetFramedEventHandler::ReadyToWrite(SocketContext& socketContext)
+	{
+		return !socketContext.connection->messagesToSend.empty();
+	}
+
+	bool NetFramedEventHandler::Disconnect(SocketContext& socketContext)
+	{
+		bufferPool.ReturnBuffers(socketContext.receiveContext.GetBuffers());
+		socketContext.receiveContext.Reset();
+		socketContext.frameDecoder.Reset();
+		socketContext.sendBatch.Clear();
+		socketContext.connection->ChangeStateToClose();
+		return true;
+	}
+
+	BufferPool<1024>& NetFramedEventHandler::GetBufferPool() noexcept
+	{
+		return bufferPool;
+	}
+
+	void NetFramedEventHandler::SetMaxMessageSize(uint32_t messageSize) noexcept
+	{
+		maxMessageSize = messageSize;
+	}
+
+	uint32_t NetFramedEventHandler::GetMaxMessageSize() const noexcept
+	{
+		return maxMessageSize;
+	}
+}
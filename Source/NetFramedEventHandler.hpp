@@ -0,0 +1,43 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include "NetContext.hpp"
+#include "BufferPool.hpp"
+
+namespace LimeEngine::Net
+{
+	// Event handler for NetProtocolFramedTCP: messages are length-prefixed and may carry binary payloads.
+	// The receive buffer is only a scratch area, complete messages are assembled by the connection's frame decoder.
+	class NetFramedEventHandler
+	{
+	public:
+		NetFramedEventHandler() = default;
+		// Receive buffers are carved out of slabs, see BufferPool(const SlabOptions&)
+		explicit NetFramedEventHandler(const SlabOptions& slabOptions);
+
+	public:
+		void StartRead(SocketContext& socketContext);
+		void Read(SocketContext& socketContext, uint32_t bytesTransferred);
+		void ReadProvided(SocketContext& socketContext, char* buffer, uint32_t bytesTransferred);
+
+		bool StartWrite(SocketContext& socketContext);
+		bool Write(SocketContext& socketContext, uint32_t bytesTransferred);
+
+		bool ReadyToWrite(SocketContext& socketContext);
+		bool Disconnect(SocketContext& socketContext);
+
+		BufferPool<1024>& GetBufferPool() noexcept;
+
+		// Connections that announce a larger payload are shut down
+		void SetMaxMessageSize(uint32_t messageSize) noexcept;
+		uint32_t GetMaxMessageSize() const noexcept;
+
+	private:
+		void Decode(SocketContext& socketContext, const char* buffer, uint32_t bytesTransferred);
+
+	private:
+		BufferPool<1024> bufferPool;
+		uint32_t maxMessageSize = NetProtocolFramedTCP::defaultMaxMessageSize;
+	};
+}
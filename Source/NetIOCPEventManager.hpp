@@ -4,9 +4,12 @@
 #pragma once
 #include <functional>
 #include <cstddef>
+#include <atomic>
 #include "BufferPool.hpp"
 #include "NetEventHandler.hpp"
+#include "NetWaitStrategy.hpp"
 
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 namespace LimeEngine::Net
 {
 	template <typename TKey, typename TContext>
@@ -27,6 +30,11 @@ namespace LimeEngine::Net
 		{
 			PostQueuedCompletionStatus(completionPort, 0, 0, nullptr);
 		}
+		// Like the close status, an empty completion that only ends the current wait
+		void PostWakeStatus()
+		{
+			PostQueuedCompletionStatus(completionPort, 0, 0, nullptr);
+		}
 
 		void Add(HANDLE handle, TKey* key)
 		{
@@ -41,7 +49,7 @@ namespace LimeEngine::Net
 		{ // INFINITE
 			static_assert(offsetof(TContext, nativeIoContext) == 0, "NativeIoContext field must be first");
 
-			NetLogger::LogCore("Wait {}ms", timeout);
+			LENET_LOG_TRACE(Poll, "Wait {}ms", timeout);
 
 			if (!GetQueuedCompletionStatus(
 					completionPort,
@@ -59,7 +67,7 @@ namespace LimeEngine::Net
 					return true;
 				}
 
-				NetLogger::LogCore("GetQueuedCompletionStatus failed: {}", err);
+				LENET_LOG_ERROR(Poll, "GetQueuedCompletionStatus failed: {}", err);
 				LENET_ERROR(err, "Can't to get CompletionStatus");
 				return false;
 			}
@@ -80,7 +88,9 @@ namespace LimeEngine::Net
 
 
 		NetIOCPEventManager(NetIOCPEventManager&& other) noexcept :
-			netEventHandler(std::move(other.netEventHandler)), completionPort(std::move(other.completionPort)), socketContexts(std::move(other.socketContexts))
+			netEventHandler(std::move(other.netEventHandler)), completionPort(std::move(other.completionPort)), pendingWrites(std::move(other.pendingWrites)),
+			socketContexts(std::move(other.socketContexts)),
+			pausedReads(std::move(other.pausedReads))
 		{}
 		NetIOCPEventManager& operator=(NetIOCPEventManager&& other) noexcept
 		{
@@ -88,7 +98,9 @@ namespace LimeEngine::Net
 			{
 				netEventHandler= std::move(other.netEventHandler);
 				completionPort = std::move(other.completionPort);
+				pendingWrites = std::move(other.pendingWrites);
 				socketContexts = std::move(other.socketContexts);
+				pausedReads = std::move(other.pausedReads);
 			}
 			return *this;
 		}
@@ -100,7 +112,9 @@ namespace LimeEngine::Net
 		void AddConnection(NetSocket&& socket, NetConnection& connection)
 		{
 			auto& socketContext = socketContexts.emplace_back(std::make_unique<SocketContext>(std::move(socket), &connection));
+			socketContext->index = socketContexts.size() - 1;
 			completionPort.Add(socketContext->socket.GetNativeSocket(), socketContext.get());
+			connection.AttachPendingWrites(&pendingWrites, &socketContext->pendingWrite);
 			netEventHandler.StartRead(*socketContext);
 
 			TNetProtocol::ReceiveAsync(socketContext->socket, &socketContext->receiveContext.netBuffer, &socketContext->receiveContext.nativeIoContext);
@@ -116,56 +130,112 @@ namespace LimeEngine::Net
 				netEventHandler.Disconnect(*socketContext);
 			}
 			socketContexts.clear();
+			pausedReads.clear();
 		}
 
 	private:
+		// Swap-and-pop, the last context takes the place of the removed one
 		void RemoveConnection(SocketContext* socketContext)
 		{
-			auto socketContextIter = std::find_if(
-				std::begin(socketContexts), std::end(socketContexts), [socketContext](const std::unique_ptr<SocketContext>& item) { return item.get() == socketContext; });
-			if (socketContextIter != std::end(socketContexts))
+			if (!netEventHandler.Disconnect(*socketContext)) return;
+			if (socketContext->readPaused) std::erase(pausedReads, socketContext);
+
+			size_t index = socketContext->index;
+			if (index != socketContexts.size() - 1)
 			{
-				if (netEventHandler.Disconnect(*socketContext)) { socketContexts.erase(socketContextIter); }
+				socketContexts[index] = std::move(socketContexts.back());
+				socketContexts[index]->index = index;
 			}
+			socketContexts.pop_back();
 		}
 
-		void ProcessSend()
+		// No receive is posted while the connection's receive queue is blocked, it is posted again once Update has drained the queue
+		void ResumeReads()
 		{
-			for (auto& socketContext : socketContexts)
+			for (size_t i = 0; i < pausedReads.size();)
 			{
-				if (netEventHandler.StartWrite(*socketContext))
+				SocketContext* socketContext = pausedReads[i];
+				if (socketContext->connection->IsReceiveBlocked())
 				{
-					TNetProtocol::SendAsync(socketContext->socket, &socketContext->sendContext.netBuffer, &socketContext->sendContext.nativeIoContext);
+					++i;
+					continue;
 				}
+				socketContext->readPaused = false;
+				pausedReads[i] = pausedReads.back();
+				pausedReads.pop_back();
+				NetMetrics::Add(NetCounter::Syscalls);
+				TNetProtocol::ReceiveAsync(socketContext->socket, &socketContext->receiveContext.netBuffer, &socketContext->receiveContext.nativeIoContext);
 			}
 		}
 
+		// Only connections that queued a message while idle are visited, send completions continue the others
+		void ProcessSend()
+		{
+			pendingWrites.Drain([this](SocketContext& socketContext) {
+				if (netEventHandler.StartWrite(socketContext))
+				{
+					NetMetrics::Add(NetCounter::Syscalls);
+					TNetProtocol::SendBuffersAsync(
+						socketContext.socket, socketContext.sendContext.GetNetBuffers(), socketContext.sendContext.GetNetBufferCount(), &socketContext.sendContext.nativeIoContext);
+				}
+			});
+		}
+
 	public:
-		void HandleNetEvents()
+		// Returns whether an operation completed
+		bool HandleNetEvents(uint32_t timeout = 100u)
 		{
+			ResumeReads();
 			ProcessSend();
 
 			uint32_t bytesTransferred;
 			SocketContext* socketContext = nullptr;
 			IOContext* ioContext = nullptr;
 
-			if (!completionPort.Wait(100, bytesTransferred, socketContext, ioContext)) return;
+			bool hasCompletion = TimedWait(timeout, [&]() { return completionPort.Wait(timeout, bytesTransferred, socketContext, ioContext); });
+			NetMetrics::Add(NetCounter::Syscalls);
+			NetMetrics::Add(NetCounter::Wakeups);
+			// Any return ends the wait a posted wake was meant for, the owner handles what was posted before waiting again
+			wakePosted.exchange(false, std::memory_order_acq_rel);
+			if (!hasCompletion)
+			{
+				NetMetrics::Add(NetCounter::EmptyWakeups);
+				return false;
+			}
 
 			if (bytesTransferred == 0) { RemoveConnection(socketContext); }
 			// Read
 			else if (ioContext->operationType == IOOperationType::Receive)
 			{
+				NetMetrics::Add(NetCounter::BytesIn, bytesTransferred);
 				netEventHandler.Read(*socketContext, bytesTransferred);
+				if (socketContext->connection->IsReceiveBlocked())
+				{
+					socketContext->readPaused = true;
+					pausedReads.push_back(socketContext);
+					return true;
+				}
+				NetMetrics::Add(NetCounter::Syscalls);
 				TNetProtocol::ReceiveAsync(socketContext->socket, &socketContext->receiveContext.netBuffer, &socketContext->receiveContext.nativeIoContext);
 			}
 			// Write
 			else if (ioContext->operationType == IOOperationType::Send)
 			{
+				NetMetrics::Add(NetCounter::BytesOut, bytesTransferred);
 				if (netEventHandler.Write(*socketContext, bytesTransferred))
 				{
-					TNetProtocol::SendAsync(socketContext->socket, &socketContext->sendContext.netBuffer, &socketContext->sendContext.nativeIoContext);
+					NetMetrics::Add(NetCounter::Syscalls);
+					TNetProtocol::SendBuffersAsync(
+						socketContext->socket, socketContext->sendContext.GetNetBuffers(), socketContext->sendContext.GetNetBufferCount(), &socketContext->sendContext.nativeIoContext);
 				}
 			}
+			return true;
+		}
+
+		// Any thread, interrupts the current or the next wait. Coalesced, one completion is posted until a wait returns
+		void Wake()
+		{
+			if (!wakePosted.exchange(true, std::memory_order_acq_rel)) completionPort.PostWakeStatus();
 		}
 
 		bool HasConnections() const
@@ -180,6 +250,11 @@ namespace LimeEngine::Net
 	private:
 		TNetEventHandler netEventHandler;
 		IOCompletionPort<SocketContext, IOContext> completionPort;
+		// Declared before the contexts, whose links unlink themselves when they are destroyed
+		NetPendingWriteList pendingWrites;
 		std::vector<std::unique_ptr<SocketContext>> socketContexts;
+		std::vector<SocketContext*> pausedReads;
+		std::atomic<bool> wakePosted = false;
 	};
 }
+#endif
@@ -0,0 +1,717 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include "BufferPool.hpp"
+#include "NetEventHandler.hpp"
+#include "NetWaitStrategy.hpp"
+#include "NetWakeup.hpp"
+
+#ifdef LE_BUILD_PLATFORM_LINUX
+	#include <linux/io_uring.h>
+	#include <linux/time_types.h>
+	#include <poll.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+
+namespace LimeEngine::Net
+{
+	// Thin wrapper over the raw io_uring syscalls (requires Linux 6.0 for multishot receive)
+	class IoUring
+	{
+	public:
+		IoUring(const IoUring&) = delete;
+		IoUring& operator=(const IoUring&) = delete;
+
+		IoUring(IoUring&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+		IoUring& operator=(IoUring&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Close();
+				ringFD = std::exchange(other.ringFD, InvalidNativeSocket);
+				sqRing = std::exchange(other.sqRing, nullptr);
+				cqRing = std::exchange(other.cqRing, nullptr);
+				sqes = std::exchange(other.sqes, nullptr);
+				sqRingSize = other.sqRingSize;
+				cqRingSize = other.cqRingSize;
+				sqesSize = other.sqesSize;
+				sqHead = other.sqHead;
+				sqTail = other.sqTail;
+				sqMask = other.sqMask;
+				sqEntries = other.sqEntries;
+				sqFlags = other.sqFlags;
+				cqHead = other.cqHead;
+				cqTail = other.cqTail;
+				cqMask = other.cqMask;
+				cqes = other.cqes;
+				sqeTail = other.sqeTail;
+				submittedTail = other.submittedTail;
+			}
+			return *this;
+		}
+
+		explicit IoUring(uint32_t entries = 1024u)
+		{
+			io_uring_params params{};
+			params.flags = IORING_SETUP_CQSIZE;
+			params.cq_entries = entries * 8u;
+
+			ringFD = static_cast<NativeSocket>(syscall(__NR_io_uring_setup, entries, &params));
+			if (ringFD < 0)
+			{
+				ringFD = InvalidNativeSocket;
+				LENET_LAST_ERROR_MSG("Can't to create io_uring");
+				return;
+			}
+			if (!(params.features & IORING_FEAT_EXT_ARG)) { LENET_MSG_ERROR("io_uring without IORING_FEAT_EXT_ARG is not supported"); }
+
+			sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+			cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+			if (singleMap) { sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize); }
+
+			sqRing = static_cast<char*>(mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_SQ_RING));
+			if (sqRing == MAP_FAILED) { LENET_LAST_ERROR_MSG("Can't to map io_uring submission ring"); }
+			if (singleMap) { cqRing = sqRing; }
+			else
+			{
+				cqRing = static_cast<char*>(mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_CQ_RING));
+				if (cqRing == MAP_FAILED) { LENET_LAST_ERROR_MSG("Can't to map io_uring completion ring"); }
+			}
+			sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_SQES));
+			if (sqes == MAP_FAILED) { LENET_LAST_ERROR_MSG("Can't to map io_uring submission entries"); }
+
+			sqHead = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.head);
+			sqTail = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.tail);
+			sqMask = *reinterpret_cast<uint32_t*>(sqRing + params.sq_off.ring_mask);
+			sqEntries = params.sq_entries;
+			sqFlags = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.flags);
+			cqHead = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.head);
+			cqTail = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.tail);
+			cqMask = *reinterpret_cast<uint32_t*>(cqRing + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+			// Submission entries are always used in ring order
+			auto sqArray = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.array);
+			for (uint32_t i = 0; i < sqEntries; ++i)
+			{
+				sqArray[i] = i;
+			}
+			sqeTail = submittedTail = *sqTail;
+		}
+		~IoUring()
+		{
+			Close();
+		}
+
+		io_uring_sqe* GetSqe()
+		{
+			if (sqeTail - std::atomic_ref(*sqHead).load(std::memory_order_acquire) >= sqEntries)
+			{
+				Submit(0, 0);
+				if (sqeTail - std::atomic_ref(*sqHead).load(std::memory_order_acquire) >= sqEntries) return nullptr;
+			}
+			io_uring_sqe* sqe = &sqes[sqeTail & sqMask];
+			memset(sqe, 0, sizeof(io_uring_sqe));
+			++sqeTail;
+			return sqe;
+		}
+
+		// Submits every prepared entry and waits for at least one completion in a single syscall
+		bool SubmitAndWait(uint32_t timeout)
+		{
+			return Submit(1, timeout);
+		}
+
+		template <typename THandler>
+		uint32_t ForEachCompletion(THandler&& handler)
+		{
+			uint32_t head = *cqHead;
+			uint32_t tail = std::atomic_ref(*cqTail).load(std::memory_order_acquire);
+			uint32_t count = tail - head;
+			for (; head != tail; ++head)
+			{
+				handler(cqes[head & cqMask]);
+			}
+			std::atomic_ref(*cqHead).store(head, std::memory_order_release);
+			return count;
+		}
+
+		bool RegisterBufferRing(io_uring_buf* ring, uint32_t ringEntries, uint16_t groupId)
+		{
+			io_uring_buf_reg reg{};
+			reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+			reg.ring_entries = ringEntries;
+			reg.bgid = groupId;
+			if (syscall(__NR_io_uring_register, ringFD, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+			{
+				LENET_LAST_ERROR_MSG("Can't to register io_uring buffer ring");
+				return false;
+			}
+			return true;
+		}
+
+		bool IsValid() const noexcept
+		{
+			return ringFD != InvalidNativeSocket;
+		}
+
+	private:
+		bool Submit(uint32_t minComplete, uint32_t timeout)
+		{
+			std::atomic_ref(*sqTail).store(sqeTail, std::memory_order_release);
+			uint32_t toSubmit = sqeTail - submittedTail;
+
+			__kernel_timespec ts{ timeout / 1000, (timeout % 1000) * 1000000ll };
+			io_uring_getevents_arg arg{};
+			arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+			uint32_t flags = IORING_ENTER_EXT_ARG;
+			if (minComplete > 0 || (std::atomic_ref(*sqFlags).load(std::memory_order_relaxed) & IORING_SQ_CQ_OVERFLOW)) flags |= IORING_ENTER_GETEVENTS;
+
+			long submitted = syscall(__NR_io_uring_enter, ringFD, toSubmit, minComplete, flags, &arg, sizeof(arg));
+			if (submitted < 0)
+			{
+				// Entries the kernel didn't consume stay published and are passed again by the next call
+				int err = errno;
+				if (err == ETIME || err == EINTR || err == EBUSY || err == EAGAIN) return false;
+				LENET_ERROR(err, "Can't to enter io_uring");
+				return false;
+			}
+			submittedTail += static_cast<uint32_t>(submitted);
+			return true;
+		}
+
+		void Close()
+		{
+			if (sqes != nullptr && sqes != MAP_FAILED) munmap(sqes, sqesSize);
+			if (cqRing != nullptr && cqRing != sqRing && cqRing != MAP_FAILED) munmap(cqRing, cqRingSize);
+			if (sqRing != nullptr && sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+			if (ringFD != InvalidNativeSocket) close(ringFD);
+			sqes = nullptr;
+			cqRing = sqRing = nullptr;
+			ringFD = InvalidNativeSocket;
+		}
+
+	private:
+		NativeSocket ringFD = InvalidNativeSocket;
+		char* sqRing = nullptr;
+		char* cqRing = nullptr;
+		io_uring_sqe* sqes = nullptr;
+		size_t sqRingSize = 0;
+		size_t cqRingSize = 0;
+		size_t sqesSize = 0;
+
+		uint32_t* sqHead = nullptr;
+		uint32_t* sqTail = nullptr;
+		uint32_t sqMask = 0;
+		uint32_t sqEntries = 0;
+		uint32_t* sqFlags = nullptr;
+		uint32_t* cqHead = nullptr;
+		uint32_t* cqTail = nullptr;
+		uint32_t cqMask = 0;
+		io_uring_cqe* cqes = nullptr;
+
+		uint32_t sqeTail = 0;
+		uint32_t submittedTail = 0;
+	};
+
+	// Kernel-selected receive buffers, every slot is backed by a buffer from BufferPool
+	template <size_t BufferSize>
+	class IoUringBufferRing
+	{
+	public:
+		IoUringBufferRing(const IoUringBufferRing&) = delete;
+		IoUringBufferRing& operator=(const IoUringBufferRing&) = delete;
+
+		IoUringBufferRing(IoUringBufferRing&& other) noexcept :
+			ring(std::exchange(other.ring, nullptr)), ringEntries(other.ringEntries), tail(other.tail), buffers(std::exchange(other.buffers, {}))
+		{}
+		IoUringBufferRing& operator=(IoUringBufferRing&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Unmap();
+				ring = std::exchange(other.ring, nullptr);
+				ringEntries = other.ringEntries;
+				tail = other.tail;
+				buffers = std::exchange(other.buffers, {});
+			}
+			return *this;
+		}
+
+		IoUringBufferRing(IoUring& ioUring, BufferPool<BufferSize>& bufferPool, uint16_t ringEntries, uint16_t groupId) : ringEntries(ringEntries), buffers(ringEntries)
+		{
+			void* memory = mmap(nullptr, ringEntries * sizeof(io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (memory == MAP_FAILED)
+			{
+				LENET_LAST_ERROR_MSG("Can't to allocate io_uring buffer ring");
+				return;
+			}
+			ring = static_cast<io_uring_buf*>(memory);
+			if (!ioUring.RegisterBufferRing(ring, ringEntries, groupId)) return;
+
+			for (uint16_t bufferId = 0; bufferId < ringEntries; ++bufferId)
+			{
+				Provide(bufferId, bufferPool.TakeBuffer());
+			}
+			Commit();
+		}
+		~IoUringBufferRing()
+		{
+			Unmap();
+		}
+
+		// Returns every buffer still provided to the kernel, the ring can't be used afterwards
+		void Release(BufferPool<BufferSize>& bufferPool)
+		{
+			for (char* buffer : buffers)
+			{
+				if (buffer != nullptr) bufferPool.ReturnBuffer(buffer);
+			}
+			buffers.clear();
+			Unmap();
+		}
+
+		// Hands the consumed buffer to the caller and refills its slot from the pool
+		char* Consume(uint16_t bufferId, BufferPool<BufferSize>& bufferPool)
+		{
+			char* buffer = buffers[bufferId];
+			Provide(bufferId, bufferPool.TakeBuffer());
+			return buffer;
+		}
+
+		void Commit()
+		{
+			std::atomic_ref(*reinterpret_cast<uint16_t*>(&ring[0].resv)).store(tail, std::memory_order_release);
+		}
+
+	private:
+		void Provide(uint16_t bufferId, char* buffer)
+		{
+			buffers[bufferId] = buffer;
+			io_uring_buf& buf = ring[tail & (ringEntries - 1u)];
+			buf.addr = reinterpret_cast<uint64_t>(buffer);
+			buf.len = BufferSize;
+			buf.bid = bufferId;
+			++tail;
+		}
+
+		void Unmap()
+		{
+			if (ring != nullptr) munmap(ring, ringEntries * sizeof(io_uring_buf));
+			ring = nullptr;
+		}
+
+	private:
+		io_uring_buf* ring = nullptr;
+		uint16_t ringEntries = 0;
+		uint16_t tail = 0;
+		std::vector<char*> buffers;
+	};
+
+	class IoUringSocketContext : public SocketContext
+	{
+	public:
+		using SocketContext::SocketContext;
+
+		uint32_t pendingOperations = 0;
+		bool closing = false;
+		// A multishot receive is armed
+		bool receiving = false;
+
+		// Must stay alive until a vectored send completes
+		msghdr sendMessage{};
+		std::array<iovec, NetSocket::maxSendBuffers> sendIovecs;
+	};
+
+	// TNetProtocol is kept for parity with NetIOCPEventManager, submissions go straight to the ring
+	template <typename TNetProtocol, typename TNetEventHandler = NetEventHandler>
+	class NetIoUringEventManager
+	{
+	private:
+		static constexpr uint16_t bufferGroupId = 0;
+		static constexpr uint16_t bufferRingEntries = 1024;
+		// Context pointers are aligned, so this never matches an encoded context
+		static constexpr uint64_t wakeupUserData = 2;
+		static constexpr size_t bufferSize = std::remove_reference_t<decltype(std::declval<TNetEventHandler&>().GetBufferPool())>::size;
+
+	public:
+		NetIoUringEventManager(const NetIoUringEventManager& other) = delete;
+		NetIoUringEventManager operator=(const NetIoUringEventManager& other) = delete;
+
+		NetIoUringEventManager(NetIoUringEventManager&& other) noexcept :
+			netEventHandler(std::move(other.netEventHandler)), wakeup(std::move(other.wakeup)), ioUring(std::move(other.ioUring)), bufferRing(std::move(other.bufferRing)),
+			pendingWrites(std::move(other.pendingWrites)), socketContexts(std::move(other.socketContexts)), closingContexts(std::move(other.closingContexts)),
+			pausedReads(std::move(other.pausedReads))
+		{}
+		NetIoUringEventManager& operator=(NetIoUringEventManager&& other) noexcept
+		{
+			if (this != &other)
+			{
+				bufferRing.Release(netEventHandler.GetBufferPool());
+				netEventHandler = std::move(other.netEventHandler);
+				wakeup = std::move(other.wakeup);
+				ioUring = std::move(other.ioUring);
+				bufferRing = std::move(other.bufferRing);
+				pendingWrites = std::move(other.pendingWrites);
+				socketContexts = std::move(other.socketContexts);
+				closingContexts = std::move(other.closingContexts);
+				pausedReads = std::move(other.pausedReads);
+			}
+			return *this;
+		}
+
+		NetIoUringEventManager() : bufferRing(ioUring, netEventHandler.GetBufferPool(), bufferRingEntries, bufferGroupId)
+		{
+			StartWakeupPoll();
+		}
+		explicit NetIoUringEventManager(TNetEventHandler&& netEventHandler) :
+			netEventHandler(std::move(netEventHandler)), bufferRing(ioUring, this->netEventHandler.GetBufferPool(), bufferRingEntries, bufferGroupId)
+		{
+			StartWakeupPoll();
+		}
+		~NetIoUringEventManager()
+		{
+			bufferRing.Release(netEventHandler.GetBufferPool());
+		}
+
+	public:
+		void AddConnection(NetSocket&& socket, NetConnection& connection)
+		{
+			auto& socketContext = socketContexts.emplace_back(std::make_unique<IoUringSocketContext>(std::move(socket), &connection));
+			socketContext->index = socketContexts.size() - 1;
+			connection.AttachPendingWrites(&pendingWrites, &socketContext->pendingWrite);
+			StartReceive(*socketContext);
+		}
+
+		void DisconnectAllConnections()
+		{
+			for (auto& socketContext : socketContexts)
+			{
+				if (socketContext->closing) continue;
+				netEventHandler.Disconnect(*socketContext);
+				Cancel(*socketContext);
+			}
+
+			// In-flight operations still reference the contexts, wait for the kernel to release them
+			for (int attempt = 0; attempt < 100 && HasPendingOperations(); ++attempt)
+			{
+				ioUring.SubmitAndWait(10);
+				ReapCompletions();
+			}
+			socketContexts.clear();
+			closingContexts.clear();
+			pausedReads.clear();
+		}
+
+	private:
+		static uint64_t EncodeUserData(IoUringSocketContext* socketContext, IOOperationType operationType) noexcept
+		{
+			return reinterpret_cast<uint64_t>(socketContext) | static_cast<uint64_t>(operationType);
+		}
+		static IoUringSocketContext* DecodeSocketContext(uint64_t userData) noexcept
+		{
+			return reinterpret_cast<IoUringSocketContext*>(userData & ~uint64_t(1));
+		}
+		static IOOperationType DecodeOperationType(uint64_t userData) noexcept
+		{
+			return static_cast<IOOperationType>(userData & 1);
+		}
+
+		// Multishot, completes every time the wakeup is signaled until it has to be re-armed
+		void StartWakeupPoll()
+		{
+			io_uring_sqe* sqe = ioUring.GetSqe();
+			if (sqe == nullptr)
+			{
+				LENET_MSG_ERROR("io_uring submission queue is full");
+				return;
+			}
+			sqe->opcode = IORING_OP_POLL_ADD;
+			sqe->fd = wakeup.GetNativeHandle();
+			sqe->len = IORING_POLL_ADD_MULTI;
+			sqe->poll32_events = POLLIN;
+			sqe->user_data = wakeupUserData;
+		}
+
+		void StartReceive(IoUringSocketContext& socketContext)
+		{
+			io_uring_sqe* sqe = ioUring.GetSqe();
+			if (sqe == nullptr)
+			{
+				LENET_MSG_ERROR("io_uring submission queue is full");
+				return;
+			}
+			sqe->opcode = IORING_OP_RECV;
+			sqe->fd = socketContext.socket.GetNativeSocket();
+			sqe->ioprio = IORING_RECV_MULTISHOT;
+			sqe->flags = IOSQE_BUFFER_SELECT;
+			sqe->buf_group = bufferGroupId;
+			sqe->user_data = EncodeUserData(&socketContext, IOOperationType::Receive);
+			++socketContext.pendingOperations;
+			socketContext.receiving = true;
+		}
+
+		// Cancels the multishot receive, its last completion is not re-armed while the context is paused
+		void PauseReceive(IoUringSocketContext& socketContext)
+		{
+			socketContext.readPaused = true;
+			pausedReads.push_back(&socketContext);
+			if (!socketContext.receiving) return;
+
+			io_uring_sqe* sqe = ioUring.GetSqe();
+			if (sqe == nullptr) return;
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->addr = EncodeUserData(&socketContext, IOOperationType::Receive);
+			sqe->user_data = 0;
+		}
+
+		// Reading resumes once Update has drained the receive queue to its low watermark
+		void ResumeReads()
+		{
+			for (size_t i = 0; i < pausedReads.size();)
+			{
+				IoUringSocketContext* socketContext = pausedReads[i];
+				if (socketContext->connection->IsReceiveBlocked())
+				{
+					++i;
+					continue;
+				}
+				socketContext->readPaused = false;
+				pausedReads[i] = pausedReads.back();
+				pausedReads.pop_back();
+				// Otherwise the cancelled receive is re-armed by its last completion
+				if (!socketContext->receiving) StartReceive(*socketContext);
+			}
+		}
+
+		void StartSend(IoUringSocketContext& socketContext)
+		{
+			io_uring_sqe* sqe = ioUring.GetSqe();
+			if (sqe == nullptr)
+			{
+				LENET_MSG_ERROR("io_uring submission queue is full");
+				return;
+			}
+			NetBuffer* netBuffers = socketContext.sendContext.GetNetBuffers();
+			uint32_t netBufferCount = std::min<uint32_t>(socketContext.sendContext.GetNetBufferCount(), NetSocket::maxSendBuffers);
+			sqe->fd = socketContext.socket.GetNativeSocket();
+			sqe->msg_flags = MSG_NOSIGNAL;
+			if (netBufferCount == 1)
+			{
+				sqe->opcode = IORING_OP_SEND;
+				sqe->addr = reinterpret_cast<uint64_t>(netBuffers->buf);
+				sqe->len = netBuffers->len;
+			}
+			else
+			{
+				for (uint32_t i = 0; i < netBufferCount; ++i)
+				{
+					socketContext.sendIovecs[i].iov_base = netBuffers[i].buf;
+					socketContext.sendIovecs[i].iov_len = netBuffers[i].len;
+				}
+				socketContext.sendMessage = msghdr{};
+				socketContext.sendMessage.msg_iov = socketContext.sendIovecs.data();
+				socketContext.sendMessage.msg_iovlen = netBufferCount;
+
+				sqe->opcode = IORING_OP_SENDMSG;
+				sqe->addr = reinterpret_cast<uint64_t>(&socketContext.sendMessage);
+				sqe->len = 1;
+			}
+			sqe->user_data = EncodeUserData(&socketContext, IOOperationType::Send);
+			++socketContext.pendingOperations;
+		}
+
+		void Cancel(IoUringSocketContext& socketContext)
+		{
+			socketContext.closing = true;
+			if (socketContext.pendingOperations == 0) return;
+
+			io_uring_sqe* sqe = ioUring.GetSqe();
+			if (sqe == nullptr) return;
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->fd = socketContext.socket.GetNativeSocket();
+			sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+			sqe->user_data = 0;
+		}
+
+		void RemoveConnection(IoUringSocketContext* socketContext)
+		{
+			if (!socketContext->closing && netEventHandler.Disconnect(*socketContext))
+			{
+				if (socketContext->readPaused) std::erase(pausedReads, socketContext);
+				Cancel(*socketContext);
+				closingContexts.push_back(socketContext);
+			}
+		}
+
+		// Only closing contexts are visited, each is released with swap-and-pop once its last operation has completed
+		void ReleaseClosedConnections()
+		{
+			for (size_t i = 0; i < closingContexts.size();)
+			{
+				IoUringSocketContext* socketContext = closingContexts[i];
+				if (socketContext->pendingOperations != 0)
+				{
+					++i;
+					continue;
+				}
+				closingContexts[i] = closingContexts.back();
+				closingContexts.pop_back();
+
+				size_t index = socketContext->index;
+				if (index != socketContexts.size() - 1)
+				{
+					socketContexts[index] = std::move(socketContexts.back());
+					socketContexts[index]->index = index;
+				}
+				socketContexts.pop_back();
+			}
+		}
+
+		bool HasPendingOperations() const
+		{
+			return std::any_of(
+				std::begin(socketContexts), std::end(socketContexts), [](const std::unique_ptr<IoUringSocketContext>& item) { return item->pendingOperations != 0; });
+		}
+
+		// Only connections that queued a message while idle are visited, send completions continue the others
+		void ProcessSend()
+		{
+			pendingWrites.Drain([this](SocketContext& socketContext) {
+				auto& ioUringSocketContext = static_cast<IoUringSocketContext&>(socketContext);
+				if (!ioUringSocketContext.closing && netEventHandler.StartWrite(ioUringSocketContext)) { StartSend(ioUringSocketContext); }
+			});
+		}
+
+		void HandleReceive(IoUringSocketContext& socketContext, const io_uring_cqe& cqe)
+		{
+			if (!(cqe.flags & IORING_CQE_F_MORE))
+			{
+				--socketContext.pendingOperations;
+				socketContext.receiving = false;
+			}
+
+			if (cqe.flags & IORING_CQE_F_BUFFER)
+			{
+				char* buffer = bufferRing.Consume(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT), netEventHandler.GetBufferPool());
+				if (cqe.res > 0) NetMetrics::Add(NetCounter::BytesIn, static_cast<uint64_t>(cqe.res));
+				if (cqe.res > 0 && !socketContext.closing) { netEventHandler.ReadProvided(socketContext, buffer, static_cast<uint32_t>(cqe.res)); }
+				else { netEventHandler.GetBufferPool().ReturnBuffer(buffer); }
+			}
+			if (socketContext.closing) return;
+
+			if (!socketContext.readPaused && socketContext.connection->IsReceiveBlocked()) PauseReceive(socketContext);
+			// A peer that closed while paused is noticed by the receive armed on resume
+			if (socketContext.readPaused) return;
+
+			if (cqe.res == -ENOBUFS || cqe.res == -ECANCELED)
+			{
+				if (!(cqe.flags & IORING_CQE_F_MORE)) StartReceive(socketContext);
+			}
+			else if (cqe.res <= 0)
+			{
+				LENET_LOG_DEBUG(IO, "Receive={}, Client {} disconnected", cqe.res, socketContext.socket.GetId());
+				RemoveConnection(&socketContext);
+			}
+			else if (!(cqe.flags & IORING_CQE_F_MORE)) { StartReceive(socketContext); }
+		}
+
+		void HandleSend(IoUringSocketContext& socketContext, const io_uring_cqe& cqe)
+		{
+			--socketContext.pendingOperations;
+			if (socketContext.closing) return;
+
+			if (cqe.res <= 0)
+			{
+				LENET_LOG_DEBUG(IO, "Send={}, Client {} disconnected", cqe.res, socketContext.socket.GetId());
+				RemoveConnection(&socketContext);
+			}
+			else
+			{
+				NetMetrics::Add(NetCounter::BytesOut, static_cast<uint64_t>(cqe.res));
+				// A short send is advanced past the sent bytes by Write, which returns true so the rest is submitted again
+				if (netEventHandler.Write(socketContext, static_cast<uint32_t>(cqe.res))) { StartSend(socketContext); }
+			}
+		}
+
+		uint32_t ReapCompletions()
+		{
+			uint32_t completions = ioUring.ForEachCompletion([this](const io_uring_cqe& cqe) {
+				if (cqe.user_data == 0) return;
+				if (cqe.user_data == wakeupUserData)
+				{
+					wakeup.Drain();
+					if (!(cqe.flags & IORING_CQE_F_MORE)) StartWakeupPoll();
+					return;
+				}
+
+				IoUringSocketContext* socketContext = DecodeSocketContext(cqe.user_data);
+				if (DecodeOperationType(cqe.user_data) == IOOperationType::Receive) { HandleReceive(*socketContext, cqe); }
+				else { HandleSend(*socketContext, cqe); }
+			});
+			bufferRing.Commit();
+			return completions;
+		}
+
+	public:
+		// Returns whether any operation completed
+		bool HandleNetEvents(uint32_t timeout = 100u)
+		{
+			ResumeReads();
+			ProcessSend();
+
+			LENET_LOG_TRACE(Poll, "Wait {}ms", timeout);
+			TimedWait(timeout, [this, timeout]() { return ioUring.SubmitAndWait(timeout); });
+			NetMetrics::Add(NetCounter::Syscalls);
+			NetMetrics::Add(NetCounter::Wakeups);
+
+			if (ReapCompletions() == 0)
+			{
+				NetMetrics::Add(NetCounter::EmptyWakeups);
+				return false;
+			}
+			ReleaseClosedConnections();
+			return true;
+		}
+
+		// Any thread, interrupts the current or the next wait
+		void Wake()
+		{
+			wakeup.Signal();
+		}
+
+		bool HasConnections() const
+		{
+			return !socketContexts.empty();
+		}
+		size_t NumberOfConnections() const
+		{
+			return socketContexts.size();
+		}
+
+	private:
+		TNetEventHandler netEventHandler;
+		NetWakeup wakeup;
+		IoUring ioUring;
+		IoUringBufferRing<bufferSize> bufferRing;
+		// Declared before the contexts, whose links unlink themselves when they are destroyed
+		NetPendingWriteList pendingWrites;
+		std::vector<std::unique_ptr<IoUringSocketContext>> socketContexts;
+		std::vector<IoUringSocketContext*> closingContexts;
+		std::vector<IoUringSocketContext*> pausedReads;
+	};
+}
+#endif
@@ -5,44 +5,127 @@
 #include <iostream>
 #include <format>
 #include <chrono>
+#include <atomic>
+#include <cstdint>
+#include "NetAsyncLogger.hpp"
+
+// Lowest level compiled in: 0 trace, 1 debug, 2 info, 3 error, 4 off
+#ifndef LENET_LOG_LEVEL
+	#ifdef NDEBUG
+		#define LENET_LOG_LEVEL 2
+	#else
+		#define LENET_LOG_LEVEL 0
+	#endif
+#endif
+
+// Mask of NetLogCategory values compiled in
+#ifndef LENET_LOG_CATEGORIES
+	#define LENET_LOG_CATEGORIES 0xF
+#endif
 
 namespace LimeEngine::Net
 {
+	enum class NetLogLevel : uint8_t
+	{
+		Trace,
+		Debug,
+		Info,
+		Error,
+		Off
+	};
+
+	enum class NetLogCategory : uint8_t
+	{
+		// Buffer pools and allocators
+		Pool = 1 << 0,
+		// Sockets, protocols and event handlers
+		IO = 1 << 1,
+		// Event managers and their event loops
+		Poll = 1 << 2,
+		User = 1 << 3
+	};
+
+	// Writes on the calling thread unless NetAsyncLogger is running.
+	// Use the LENET_LOG_* macros: calls below LENET_LOG_LEVEL or outside LENET_LOG_CATEGORIES compile to nothing, arguments included.
 	class NetLogger
 	{
 		NetLogger() = delete;
 
-	private:
-		static inline int ElapsedSeconds()
-		{
-			static auto start = std::chrono::system_clock::now();
-			auto end = std::chrono::system_clock::now();
-			std::chrono::duration<double> elapsed_seconds = end - start;
-			return elapsed_seconds.count() * 100;
-		}
+		// Through a variable, a literal 0 would make the level check an always-true comparison (-Wtype-limits)
+		static constexpr int minLevel = LENET_LOG_LEVEL;
 
 	public:
-		static void LogCore(const std::string& msg)
+		static constexpr bool IsCompiledIn(NetLogLevel level, NetLogCategory category) noexcept
 		{
-			std::cout << "[Net " << ElapsedSeconds() << "ms] " << msg << std::endl;
+			return level != NetLogLevel::Off && static_cast<int>(level) >= minLevel && (static_cast<int>(category) & (LENET_LOG_CATEGORIES)) != 0;
 		}
-		template <typename... TArgs>
-		static void LogCore(const std::format_string<TArgs...> formatMsg, TArgs&&... args)
+		static bool IsEnabled(NetLogLevel level) noexcept
 		{
-			std::cout << "[Net " << ElapsedSeconds() << "ms] " << std::format(formatMsg, std::forward<TArgs>(args)...) << std::endl;
+			return level >= threshold.load(std::memory_order_relaxed);
+		}
+		// Runtime threshold for the levels that are compiled in
+		static void SetLevel(NetLogLevel level) noexcept
+		{
+			threshold.store(level, std::memory_order_relaxed);
+		}
+		static NetLogLevel GetLevel() noexcept
+		{
+			return threshold.load(std::memory_order_relaxed);
+		}
+
+		static constexpr const char* CategoryName(NetLogCategory category) noexcept
+		{
+			switch (category)
+			{
+				case NetLogCategory::Pool: return "Pool";
+				case NetLogCategory::IO: return "IO";
+				case NetLogCategory::Poll: return "Poll";
+				case NetLogCategory::User: return "User";
+			}
+			return "Net";
 		}
 
-		static void LogUser(const std::string& msg)
+		static void Log(NetLogCategory category, const std::string& msg)
 		{
-			std::cout << "[User " << ElapsedSeconds() << "ms] " << msg << std::endl;
+			if (NetAsyncLogger::IsRunning()) { NetAsyncLogger::Log(CategoryName(category), msg); }
+			else { std::cout << "[" << CategoryName(category) << " " << NetAsyncLogger::ElapsedMilliseconds() << "ms] " << msg << std::endl; }
 		}
 		template <typename... TArgs>
-		static void LogUser(const std::format_string<TArgs...> formatMsg, TArgs&&... args)
+		static void Log(NetLogCategory category, const std::format_string<TArgs...> formatMsg, TArgs&&... args)
 		{
-			std::cout << "[User " << ElapsedSeconds() << "ms] " << std::format(formatMsg, std::forward<TArgs>(args)...) << std::endl;
+			if (NetAsyncLogger::IsRunning()) { NetAsyncLogger::Log(CategoryName(category), formatMsg, std::forward<TArgs>(args)...); }
+			else
+			{
+				std::cout << "[" << CategoryName(category) << " " << NetAsyncLogger::ElapsedMilliseconds() << "ms] " << std::format(formatMsg, std::forward<TArgs>(args)...)
+						  << std::endl;
+			}
+		}
+
+		// Makes sure everything logged so far is written, e.g. before breaking into the debugger
+		static void Flush()
+		{
+			if (NetAsyncLogger::IsRunning()) NetAsyncLogger::Flush();
 		}
 
 	private:
-		inline static auto runTime = std::chrono::system_clock::now();
+		inline static std::atomic<NetLogLevel> threshold = NetLogLevel::Trace;
 	};
 }
+
+#define LENET_LOG_ENABLED(level, category)                                                                                             \
+	(::LimeEngine::Net::NetLogger::IsCompiledIn(::LimeEngine::Net::NetLogLevel::level, ::LimeEngine::Net::NetLogCategory::category) && \
+	 ::LimeEngine::Net::NetLogger::IsEnabled(::LimeEngine::Net::NetLogLevel::level))
+
+#define LENET_LOG(level, category, ...)                                                                                                             \
+	do {                                                                                                                                            \
+		if constexpr (::LimeEngine::Net::NetLogger::IsCompiledIn(::LimeEngine::Net::NetLogLevel::level, ::LimeEngine::Net::NetLogCategory::category)) \
+		{                                                                                                                                           \
+			if (::LimeEngine::Net::NetLogger::IsEnabled(::LimeEngine::Net::NetLogLevel::level))                                                     \
+				::LimeEngine::Net::NetLogger::Log(::LimeEngine::Net::NetLogCategory::category, __VA_ARGS__);                                        \
+		}                                                                                                                                           \
+	} while (false)
+
+#define LENET_LOG_TRACE(category, ...) LENET_LOG(Trace, category, __VA_ARGS__)
+#define LENET_LOG_DEBUG(category, ...) LENET_LOG(Debug, category, __VA_ARGS__)
+#define LENET_LOG_INFO(category, ...)  LENET_LOG(Info, category, __VA_ARGS__)
+#define LENET_LOG_ERROR(category, ...) LENET_LOG(Error, category, __VA_ARGS__)
@@ -0,0 +1,155 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetMetrics.hpp"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <iterator>
+
+namespace LimeEngine::Net
+{
+	namespace
+	{
+		struct MetricsRegistry
+		{
+			std::mutex mutex;
+			// Blocks of exited threads are kept, so counters never go backwards
+			std::deque<std::unique_ptr<NetThreadMetrics>> threads;
+		};
+
+		MetricsRegistry& Registry()
+		{
+			static MetricsRegistry registry;
+			return registry;
+		}
+
+		NetMetricsSnapshot Load(const NetThreadMetrics& threadMetrics)
+		{
+			NetMetricsSnapshot snapshot;
+			snapshot.threadName = threadMetrics.threadName;
+			for (size_t i = 0; i < netCounterCount; ++i)
+			{
+				snapshot.counters[i] = threadMetrics.counters[i].load(std::memory_order_relaxed);
+			}
+			for (size_t i = 0; i < netGaugeCount; ++i)
+			{
+				snapshot.gauges[i] = threadMetrics.gauges[i].load(std::memory_order_relaxed);
+			}
+			return snapshot;
+		}
+
+		NetMetricsSnapshot Sum(const std::vector<NetMetricsSnapshot>& snapshots)
+		{
+			NetMetricsSnapshot total;
+			for (auto& snapshot : snapshots)
+			{
+				for (size_t i = 0; i < netCounterCount; ++i)
+				{
+					total.counters[i] += snapshot.counters[i];
+				}
+				for (size_t i = 0; i < netGaugeCount; ++i)
+				{
+					total.gauges[i] += snapshot.gauges[i];
+				}
+			}
+			return total;
+		}
+
+		void AppendMetrics(std::string& out, const NetMetricsSnapshot& snapshot, const std::string& label)
+		{
+			for (size_t i = 0; i < netCounterCount; ++i)
+			{
+				std::format_to(std::back_inserter(out), "lenet_{}{} {}\n", GetNetCounterName(static_cast<NetCounter>(i)), label, snapshot.counters[i]);
+			}
+			for (size_t i = 0; i < netGaugeCount; ++i)
+			{
+				std::format_to(std::back_inserter(out), "lenet_{}{} {}\n", GetNetGaugeName(static_cast<NetGauge>(i)), label, snapshot.gauges[i]);
+			}
+		}
+	}
+
+	const char* GetNetCounterName(NetCounter counter) noexcept
+	{
+		switch (counter)
+		{
+			case NetCounter::BytesIn: return "bytes_in";
+			case NetCounter::BytesOut: return "bytes_out";
+			case NetCounter::MessagesIn: return "messages_in";
+			case NetCounter::MessagesOut: return "messages_out";
+			case NetCounter::Syscalls: return "syscalls";
+			case NetCounter::Wakeups: return "wakeups";
+			case NetCounter::EmptyWakeups: return "empty_wakeups";
+			case NetCounter::SpinNanoseconds: return "spin_ns";
+			case NetCounter::BlockedNanoseconds: return "blocked_ns";
+			case NetCounter::Accepts: return "accepts";
+			case NetCounter::Disconnects: return "disconnects";
+			case NetCounter::PoolHits: return "pool_hits";
+			case NetCounter::PoolMisses: return "pool_misses";
+			case NetCounter::ReadPauses: return "read_pauses";
+			case NetCounter::SendOverflows: return "send_overflows";
+			case NetCounter::PostedSends: return "posted_sends";
+			case NetCounter::DroppedDatagrams: return "dropped_datagrams";
+			default: return "unknown";
+		}
+	}
+
+	const char* GetNetGaugeName(NetGauge gauge) noexcept
+	{
+		switch (gauge)
+		{
+			case NetGauge::Connections: return "connections";
+			case NetGauge::QueuedSendBytes: return "queued_send_bytes";
+			case NetGauge::QueuedReceiveBytes: return "queued_receive_bytes";
+			case NetGauge::FreeBuffers: return "free_buffers";
+			default: return "unknown";
+		}
+	}
+
+	void NetMetrics::SetThreadName(const std::string& name)
+	{
+		auto& threadMetrics = ThreadMetrics();
+		std::lock_guard lock(Registry().mutex);
+		threadMetrics.threadName = name;
+	}
+
+	NetMetricsSnapshot NetMetrics::Snapshot()
+	{
+		return Sum(ThreadSnapshots());
+	}
+
+	std::vector<NetMetricsSnapshot> NetMetrics::ThreadSnapshots()
+	{
+		auto& registry = Registry();
+		std::lock_guard lock(registry.mutex);
+
+		std::vector<NetMetricsSnapshot> snapshots;
+		snapshots.reserve(registry.threads.size());
+		for (auto& threadMetrics : registry.threads)
+		{
+			snapshots.push_back(Load(*threadMetrics));
+		}
+		return snapshots;
+	}
+
+	std::string NetMetrics::Dump()
+	{
+		auto snapshots = ThreadSnapshots();
+
+		std::string out;
+		AppendMetrics(out, Sum(snapshots), "");
+		for (size_t i = 0; i < snapshots.size(); ++i)
+		{
+			const std::string& name = snapshots[i].threadName;
+			AppendMetrics(out, snapshots[i], std::format("{{thread=\"{}\"}}", name.empty() ? std::format("{}", i) : name));
+		}
+		return out;
+	}
+
+	NetThreadMetrics* NetMetrics::RegisterThread()
+	{
+		auto& registry = Registry();
+		std::lock_guard lock(registry.mutex);
+		return registry.threads.emplace_back(std::make_unique<NetThreadMetrics>()).get();
+	}
+}
@@ -0,0 +1,121 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <atomic>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "NetBase.hpp"
+
+namespace LimeEngine::Net
+{
+	enum class NetCounter : uint8_t
+	{
+		BytesIn,
+		BytesOut,
+		MessagesIn,
+		MessagesOut,
+		Syscalls,
+		Wakeups,
+		// Wakeups that returned without any event
+		EmptyWakeups,
+		// Time spent in polls of the event loop that found no event
+		SpinNanoseconds,
+		// Time spent blocked in waits
+		BlockedNanoseconds,
+		Accepts,
+		Disconnects,
+		PoolHits,
+		// Takes that had to allocate a buffer
+		PoolMisses,
+		// Connections that stopped reading because their receive queue reached the high watermark
+		ReadPauses,
+		// Sends that took a send queue over its high watermark
+		SendOverflows,
+		// Messages queued by NetServer::Send for a worker thread
+		PostedSends,
+		// Received datagrams larger than a buffer
+		DroppedDatagrams,
+		Count
+	};
+
+	// Gauges are kept as per-thread deltas, their sum is the current value
+	enum class NetGauge : uint8_t
+	{
+		Connections,
+		QueuedSendBytes,
+		QueuedReceiveBytes,
+		FreeBuffers,
+		Count
+	};
+
+	static constexpr size_t netCounterCount = static_cast<size_t>(NetCounter::Count);
+	static constexpr size_t netGaugeCount = static_cast<size_t>(NetGauge::Count);
+
+	const char* GetNetCounterName(NetCounter counter) noexcept;
+	const char* GetNetGaugeName(NetGauge gauge) noexcept;
+
+	struct NetMetricsSnapshot
+	{
+		uint64_t Get(NetCounter counter) const noexcept
+		{
+			return counters[static_cast<size_t>(counter)];
+		}
+		int64_t Get(NetGauge gauge) const noexcept
+		{
+			return gauges[static_cast<size_t>(gauge)];
+		}
+
+		std::string threadName;
+		std::array<uint64_t, netCounterCount> counters{};
+		std::array<int64_t, netGaugeCount> gauges{};
+	};
+
+	// Metrics of one thread, written by that thread only. Padded so that no two threads share a cache line.
+	struct alignas(CacheLineSize) NetThreadMetrics
+	{
+		std::array<std::atomic<uint64_t>, netCounterCount> counters{};
+		std::array<std::atomic<int64_t>, netGaugeCount> gauges{};
+		std::string threadName;
+	};
+
+	// Counters are updated with a relaxed load and store on a block of the calling thread, nothing is shared on the hot path.
+	// Snapshots sum the blocks of every thread that has ever updated a metric.
+	class NetMetrics
+	{
+		NetMetrics() = delete;
+
+	public:
+		static void Add(NetCounter counter, uint64_t value = 1u)
+		{
+			auto& metric = ThreadMetrics().counters[static_cast<size_t>(counter)];
+			metric.store(metric.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+		static void Add(NetGauge gauge, int64_t delta)
+		{
+			auto& metric = ThreadMetrics().gauges[static_cast<size_t>(gauge)];
+			metric.store(metric.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+		}
+
+		// Shown as the thread label of the plain-text dump
+		static void SetThreadName(const std::string& name);
+
+		static NetMetricsSnapshot Snapshot();
+		static std::vector<NetMetricsSnapshot> ThreadSnapshots();
+		// Plain-text dump, one "name value" line per metric, totals first and then every thread
+		static std::string Dump();
+
+	private:
+		static NetThreadMetrics& ThreadMetrics()
+		{
+			if (threadMetrics == nullptr) threadMetrics = RegisterThread();
+			return *threadMetrics;
+		}
+		static NetThreadMetrics* RegisterThread();
+
+	private:
+		inline static thread_local NetThreadMetrics* threadMetrics = nullptr;
+	};
+}
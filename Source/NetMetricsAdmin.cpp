@@ -0,0 +1,81 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetMetricsAdmin.hpp"
+#include <string_view>
+
+namespace LimeEngine::Net
+{
+	NetMetricsAdmin::NetMetricsAdmin(NetSocketIPv4Address address) : listenSocket(NetAddressType::IPv4)
+	{
+		listenSocket.SetReuseAddr();
+		listenSocket.SetNonblockingMode();
+		listenSocket.Bind(address);
+		listenSocket.Listen();
+	}
+
+	NetMetricsAdmin::~NetMetricsAdmin()
+	{
+		Stop();
+	}
+
+	void NetMetricsAdmin::Start()
+	{
+		if (thread.joinable()) return;
+		running.store(true, std::memory_order_release);
+		thread = std::thread(&NetMetricsAdmin::Run, this);
+	}
+
+	void NetMetricsAdmin::Stop()
+	{
+		if (!thread.joinable()) return;
+		running.store(false, std::memory_order_release);
+		thread.join();
+	}
+
+	void NetMetricsAdmin::Run()
+	{
+		NetMetrics::SetThreadName("metrics admin");
+		while (running.load(std::memory_order_acquire))
+		{
+			if (!listenSocket.WaitForRead(stopCheckInterval)) continue;
+
+			NetSocket client;
+			while (listenSocket.Accept(client))
+			{
+				Respond(client);
+				client.Close();
+			}
+		}
+	}
+
+	void NetMetricsAdmin::Respond(NetSocket& client)
+	{
+		client.SetNonblockingMode(false);
+
+		// Scrapers speak HTTP, plain connections (nc, telnet) get the bare dump
+		bool isHttp = false;
+		if (client.WaitForRead(requestTimeout))
+		{
+			std::array<char, 1024> request;
+			int bytesReceived;
+			if (client.Receive(request.data(), static_cast<int>(request.size()), bytesReceived))
+			{
+				isHttp = std::string_view(request.data(), bytesReceived).starts_with("GET ");
+			}
+		}
+
+		std::string response = isHttp ? "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n" : "";
+		response += NetMetrics::Dump();
+		const char* data = response.data();
+		int remaining = static_cast<int>(response.size());
+		while (remaining > 0)
+		{
+			int bytesSent;
+			if (!client.Send(data, remaining, bytesSent)) return;
+			data += bytesSent;
+			remaining -= bytesSent;
+		}
+		client.Shutdown();
+	}
+}
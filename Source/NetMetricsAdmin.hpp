@@ -0,0 +1,41 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <atomic>
+#include <thread>
+#include "NetSockets.hpp"
+#include "NetMetrics.hpp"
+
+namespace LimeEngine::Net
+{
+	// Answers every connection with the plain-text NetMetrics::Dump() and closes it, e.g. `curl 127.0.0.1:9100` or `nc 127.0.0.1 9100`.
+	// Connections are served one at a time on the admin thread.
+	// Runs on its own thread and only reads the metrics, the event loops are not involved.
+	class NetMetricsAdmin
+	{
+	private:
+		static constexpr uint32_t stopCheckInterval = 100u;
+		static constexpr uint32_t requestTimeout = 50u;
+
+	public:
+		NetMetricsAdmin(const NetMetricsAdmin&) = delete;
+		NetMetricsAdmin& operator=(const NetMetricsAdmin&) = delete;
+
+		// Bind to a loopback address unless the metrics may be exposed
+		explicit NetMetricsAdmin(NetSocketIPv4Address address);
+		~NetMetricsAdmin();
+
+		void Start();
+		void Stop();
+
+	private:
+		void Run();
+		void Respond(NetSocket& client);
+
+	private:
+		NetSocket listenSocket;
+		std::atomic<bool> running = false;
+		std::thread thread;
+	};
+}
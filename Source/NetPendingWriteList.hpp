@@ -0,0 +1,114 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <utility>
+
+namespace LimeEngine::Net
+{
+	class SocketContext;
+
+	// Embedded in the socket context, so listing a connection and taking it off the list never allocates.
+	// A link points back to the pointer that points to it (like the kernel's hlist), so it can be unlinked without knowing the list.
+	class NetPendingWriteLink
+	{
+	public:
+		explicit NetPendingWriteLink(SocketContext* owner) noexcept : owner(owner) {}
+		~NetPendingWriteLink()
+		{
+			Unlink();
+		}
+
+		NetPendingWriteLink(const NetPendingWriteLink&) = delete;
+		NetPendingWriteLink& operator=(const NetPendingWriteLink&) = delete;
+
+		bool IsLinked() const noexcept
+		{
+			return previousNext != nullptr;
+		}
+		void Unlink() noexcept
+		{
+			if (previousNext == nullptr) return;
+			*previousNext = next;
+			if (next != nullptr) next->previousNext = previousNext;
+			next = nullptr;
+			previousNext = nullptr;
+		}
+
+	private:
+		friend class NetPendingWriteList;
+
+		SocketContext* owner;
+		NetPendingWriteLink* next = nullptr;
+		NetPendingWriteLink** previousNext = nullptr;
+	};
+
+	// Socket contexts whose connection queued a message while it had nothing to send. The event manager only starts writes
+	// for these instead of checking every connection, writes in flight pick up the messages queued meanwhile by themselves.
+	class NetPendingWriteList
+	{
+	public:
+		NetPendingWriteList() noexcept = default;
+		NetPendingWriteList(const NetPendingWriteList&) = delete;
+		NetPendingWriteList& operator=(const NetPendingWriteList&) = delete;
+
+		// The first link points back to the head, which moves with the list
+		NetPendingWriteList(NetPendingWriteList&& other) noexcept : head(std::exchange(other.head, nullptr))
+		{
+			if (head != nullptr) head->previousNext = &head;
+		}
+		NetPendingWriteList& operator=(NetPendingWriteList&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Clear();
+				head = std::exchange(other.head, nullptr);
+				if (head != nullptr) head->previousNext = &head;
+			}
+			return *this;
+		}
+		~NetPendingWriteList()
+		{
+			Clear();
+		}
+
+		// Listed once, no matter how often it is pushed
+		void Push(NetPendingWriteLink& link) noexcept
+		{
+			if (link.IsLinked()) return;
+			link.next = head;
+			if (head != nullptr) head->previousNext = &link.next;
+			head = &link;
+			link.previousNext = &head;
+		}
+
+		// Every context is unlinked before func is called
+		template <typename TFunc>
+		void Drain(TFunc&& func)
+		{
+			while (head != nullptr)
+			{
+				NetPendingWriteLink* link = head;
+				link->Unlink();
+				func(*link->owner);
+			}
+		}
+
+		bool Empty() const noexcept
+		{
+			return head == nullptr;
+		}
+
+	private:
+		void Clear() noexcept
+		{
+			while (head != nullptr)
+			{
+				head->Unlink();
+			}
+		}
+
+	private:
+		NetPendingWriteLink* head = nullptr;
+	};
+}
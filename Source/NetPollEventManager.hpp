@@ -3,6 +3,7 @@
 
 #pragma once
 #include "NetBufferBasedEventManager.hpp"
+#include "NetWakeup.hpp"
 
 namespace LimeEngine::Net
 {
@@ -11,9 +12,25 @@ namespace LimeEngine::Net
 	template <typename TNetDataHandler, typename TNetEventHandler = NetEventHandler>
 	using NetPollEventManager = NetBufferBasedEventManager<NetPollBuffer, TNetDataHandler, TNetEventHandler>;
 
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	using NativePollFD = WSAPOLLFD;
+
+	inline int NativePoll(NativePollFD* fds, size_t count, uint32_t timeout)
+	{
+		return WSAPoll(fds, static_cast<ULONG>(count), static_cast<INT>(timeout));
+	}
+#else
+	using NativePollFD = pollfd;
+
+	inline int NativePoll(NativePollFD* fds, size_t count, uint32_t timeout)
+	{
+		return poll(fds, static_cast<nfds_t>(count), static_cast<int>(timeout));
+	}
+#endif
+
 	struct PollFD
 	{
-		explicit PollFD(NativeSocket fd, SHORT events = POLLRDNORM, SHORT revents = 0) : fd(fd), events(events), revents(revents) {}
+		explicit PollFD(NativeSocket fd, short events = POLLRDNORM, short revents = 0) : fd(fd), events(events), revents(revents) {}
 
 		bool CheckRead() const
 		{
@@ -36,61 +53,112 @@ namespace LimeEngine::Net
 			return revents != 0;
 		}
 
-		void SetFlag(SHORT flags = POLLRDNORM)
+		void SetFlag(short flags = POLLRDNORM)
+		{
+			events |= flags;
+		}
+		void ResetFlag(short flags)
 		{
-			events = flags;
+			events &= ~flags;
 		}
 
 	private:
 		NativeSocket fd;
-		SHORT events;
-		SHORT revents;
+		short events;
+		short revents;
 	};
+	static_assert(sizeof(PollFD) == sizeof(NativePollFD), "PollFD must match the native poll layout");
 
+	// The wakeup handle is polled first, connection indices are offset by one internally
 	class NetPollBuffer
 	{
 	public:
+		static constexpr bool edgeTriggered = false;
+
+		NetPollBuffer()
+		{
+			// eventfd only reports POLLIN
+			pollFDs.emplace_back(wakeup.GetNativeHandle(), POLLIN, 0);
+		}
+
 		bool Add(NativeSocket fd)
 		{
 			pollFDs.emplace_back(fd, POLLRDNORM, 0);
 			return true;
 		}
+		// The last socket takes the place of the removed one
 		void Remove(size_t index)
 		{
-			pollFDs.erase(std::begin(pollFDs) + index);
+			pollFDs[index + 1] = pollFDs.back();
+			pollFDs.pop_back();
 		}
 
 		int WaitForEvents(uint32_t timeout)
 		{
-			int result = WSAPoll(reinterpret_cast<WSAPOLLFD*>(pollFDs.data()), pollFDs.size(), timeout);
+			int result = NativePoll(reinterpret_cast<NativePollFD*>(pollFDs.data()), pollFDs.size(), timeout);
 			if (result < 0)
 			{
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+				if (errno == EINTR) return 0;
+#endif
 				LENET_LAST_ERROR_MSG("Can't to poll");
 				return 0;
 			}
+			if (pollFDs.front().IsChanged())
+			{
+				wakeup.Drain();
+				--result;
+			}
 			return result;
 		}
 
+		// Any thread, interrupts the current or the next wait
+		void Wake()
+		{
+			wakeup.Signal();
+		}
+
+		void SetReadFlag(size_t index)
+		{
+			pollFDs[index + 1].SetFlag(POLLRDNORM);
+		}
+		void ResetReadFlag(size_t index)
+		{
+			pollFDs[index + 1].ResetFlag(POLLRDNORM);
+		}
 		void SetWriteFlag(size_t index)
 		{
-			pollFDs[index].SetFlag(POLLRDNORM | POLLWRNORM);
+			pollFDs[index + 1].SetFlag(POLLWRNORM);
 		}
 		void ResetWriteFlag(size_t index)
 		{
-			pollFDs[index].SetFlag(POLLRDNORM);
+			pollFDs[index + 1].ResetFlag(POLLWRNORM);
 		}
 
 		size_t Count() const
 		{
-			return pollFDs.size();
+			return pollFDs.size() - 1;
 		}
 		bool Empty() const
 		{
-			return pollFDs.empty();
+			return pollFDs.size() == 1;
 		}
 		PollFD& At(size_t index)
 		{
-			return pollFDs[index];
+			return pollFDs[index + 1];
+		}
+
+		size_t EventsCount() const
+		{
+			return pollFDs.size() - 1;
+		}
+		size_t EventSocketIndex(size_t eventIndex) const
+		{
+			return eventIndex;
+		}
+		PollFD& EventAt(size_t eventIndex)
+		{
+			return At(eventIndex);
 		}
 
 		void Log() const
@@ -99,12 +167,12 @@ namespace LimeEngine::Net
 			oss << "[Poll] Expected:";
 			for (auto& pollFD : pollFDs)
 			{
-				auto& wsaPollFD = *reinterpret_cast<const WSAPOLLFD*>(&pollFD);
+				auto& nativePollFD = *reinterpret_cast<const NativePollFD*>(&pollFD);
 				oss << '[';
-				oss << ((wsaPollFD.events & POLLRDNORM) ? "R" : "");
-				oss << ((wsaPollFD.events & POLLWRNORM) ? "W" : "");
-				oss << ((wsaPollFD.events & POLLERR) ? "E" : "");
-				oss << ((wsaPollFD.events & POLLHUP) ? "D" : "");
+				oss << ((nativePollFD.events & POLLRDNORM) ? "R" : "");
+				oss << ((nativePollFD.events & POLLWRNORM) ? "W" : "");
+				oss << ((nativePollFD.events & POLLERR) ? "E" : "");
+				oss << ((nativePollFD.events & POLLHUP) ? "D" : "");
 				oss << ']';
 			}
 			oss << " Actual:";
@@ -117,10 +185,11 @@ namespace LimeEngine::Net
 				oss << ((pollFD.CheckDisconnect()) ? "D" : "");
 				oss << ']';
 			}
-			NetLogger::LogCore(oss.str());
+			LENET_LOG_TRACE(Poll, oss.str());
 		}
 
 	private:
+		NetWakeup wakeup;
 		std::vector<PollFD> pollFDs;
 	};
 }
@@ -0,0 +1,45 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace LimeEngine::Net
+{
+	// Ids of connections with received messages or a pending disconnect, in the order they became ready.
+	// Lets the owner dispatch without visiting idle connections. The connection itself makes sure it is listed once.
+	class NetReadyList
+	{
+	public:
+		void Push(uint64_t connectionId)
+		{
+			ready.push_back(connectionId);
+		}
+
+		// Connections that become ready while draining are kept for the next drain
+		template <typename TFunc>
+		void Drain(TFunc&& func)
+		{
+			draining.swap(ready);
+			for (uint64_t connectionId : draining)
+			{
+				func(connectionId);
+			}
+			draining.clear();
+		}
+
+		bool Empty() const noexcept
+		{
+			return ready.empty();
+		}
+		size_t Size() const noexcept
+		{
+			return ready.size();
+		}
+
+	private:
+		std::vector<uint64_t> ready;
+		std::vector<uint64_t> draining;
+	};
+}
@@ -0,0 +1,177 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <utility>
+#include "Protocols/NetProtocolFramedTCP.hpp"
+
+namespace LimeEngine::Net
+{
+	// Per-connection receive ring of NetProtocolFramedTCP frames. The socket reads straight into the free part of the ring
+	// and complete frames are handed out as views into it. A frame is only copied when it wraps around the end of the ring
+	// or does not fit into the ring at all.
+	class NetReceiveRing
+	{
+	public:
+		// Capacity must be a power of two
+		void Attach(char* ringStorage, size_t ringCapacity) noexcept
+		{
+			storage = ringStorage;
+			capacity = ringCapacity;
+			readPosition = 0;
+			writePosition = 0;
+		}
+		char* Detach() noexcept
+		{
+			char* ringStorage = storage;
+			storage = nullptr;
+			capacity = 0;
+			Reset();
+			return ringStorage;
+		}
+		bool IsAttached() const noexcept
+		{
+			return storage != nullptr;
+		}
+
+		// Contiguous free region the next receive can write into
+		std::pair<char*, uint32_t> WritableRegion() const noexcept
+		{
+			size_t offset = writePosition & (capacity - 1);
+			size_t free = capacity - ReadableSize();
+			return std::make_pair(storage + offset, static_cast<uint32_t>(std::min(free, capacity - offset)));
+		}
+		void Commit(size_t bytesWritten) noexcept
+		{
+			writePosition += bytesWritten;
+		}
+		// Copies as much as fits, returns the number of bytes copied
+		size_t Append(const char* data, size_t size) noexcept
+		{
+			size_t copied = 0;
+			while (copied != size)
+			{
+				auto [region, regionSize] = WritableRegion();
+				if (regionSize == 0) break;
+				size_t part = std::min<size_t>(regionSize, size - copied);
+				memcpy(region, data + copied, part);
+				Commit(part);
+				copied += part;
+			}
+			return copied;
+		}
+
+		bool Empty() const noexcept
+		{
+			return ReadableSize() == 0 && largeRemaining == 0;
+		}
+		size_t ReadableSize() const noexcept
+		{
+			return static_cast<size_t>(writePosition - readPosition);
+		}
+
+		// Calls onMessage(std::string_view) for every complete frame, the view is only valid during the call.
+		// wrapScratch is reused for frames that wrap around. Returns false on a malformed stream or a payload over maxMessageSize.
+		template <typename TOnMessage>
+		bool ParseFrames(std::string& wrapScratch, TOnMessage&& onMessage, uint32_t maxMessageSize = NetProtocolFramedTCP::defaultMaxMessageSize)
+		{
+			if (failed) return false;
+			while (true)
+			{
+				if (largeRemaining != 0)
+				{
+					size_t part = std::min(largeRemaining, ReadableSize());
+					PeekAppend(large, part);
+					Consume(part);
+					largeRemaining -= part;
+					if (largeRemaining != 0) return true;
+
+					onMessage(std::string_view(large));
+					large = std::string();
+					continue;
+				}
+
+				if (ReadableSize() < NetProtocolFramedTCP::headerSize) return true;
+
+				char header[NetProtocolFramedTCP::headerSize];
+				Peek(header, 0, sizeof(header));
+				uint32_t messageSize = NetProtocolFramedTCP::DecodeHeader(header);
+				if (messageSize > maxMessageSize)
+				{
+					LENET_LOG_ERROR(IO, "[Frame] Message size {} exceeds the limit", messageSize);
+					failed = true;
+					return false;
+				}
+
+				// Never fits into the ring, assembled on the side as it arrives
+				if (NetProtocolFramedTCP::headerSize + messageSize > capacity)
+				{
+					Consume(NetProtocolFramedTCP::headerSize);
+					large.reserve(std::min<size_t>(messageSize, capacity));
+					largeRemaining = messageSize;
+					continue;
+				}
+
+				if (ReadableSize() < NetProtocolFramedTCP::headerSize + messageSize) return true;
+				Consume(NetProtocolFramedTCP::headerSize);
+
+				size_t offset = readPosition & (capacity - 1);
+				if (offset + messageSize <= capacity) { onMessage(std::string_view(storage + offset, messageSize)); }
+				else
+				{
+					wrapScratch.clear();
+					PeekAppend(wrapScratch, messageSize);
+					onMessage(std::string_view(wrapScratch));
+				}
+				Consume(messageSize);
+			}
+		}
+
+		void Reset() noexcept
+		{
+			readPosition = 0;
+			writePosition = 0;
+			large = std::string();
+			largeRemaining = 0;
+			failed = false;
+		}
+
+	private:
+		void Peek(char* out, size_t skip, size_t size) const noexcept
+		{
+			size_t offset = (readPosition + skip) & (capacity - 1);
+			size_t first = std::min(size, capacity - offset);
+			memcpy(out, storage + offset, first);
+			memcpy(out + first, storage, size - first);
+		}
+		void PeekAppend(std::string& out, size_t size) const
+		{
+			size_t offset = readPosition & (capacity - 1);
+			size_t first = std::min(size, capacity - offset);
+			out.append(storage + offset, first);
+			out.append(storage, size - first);
+		}
+		void Consume(size_t size) noexcept
+		{
+			readPosition += size;
+			// Rewinding an empty ring keeps the next receive contiguous
+			if (readPosition == writePosition)
+			{
+				readPosition = 0;
+				writePosition = 0;
+			}
+		}
+
+	private:
+		char* storage = nullptr;
+		size_t capacity = 0;
+		uint64_t readPosition = 0;
+		uint64_t writePosition = 0;
+
+		std::string large;
+		size_t largeRemaining = 0;
+		bool failed = false;
+	};
+}
@@ -0,0 +1,84 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetRingEventHandler.hpp"
+
+namespace LimeEngine::Net
+{
+	NetRingEventHandler::NetRingEventHandler(const SlabOptions& slabOptions) :
+		NetFramedEventHandler(slabOptions), ringPool(SlabOptions{ .hugePages = slabOptions.hugePages })
+	{}
+
+	void NetRingEventHandler::StartRead(SocketContext& socketContext)
+	{
+		socketContext.receiveRing.Attach(ringPool.TakeBuffer(), ringPool.size);
+		SetNextReceive(socketContext);
+	}
+
+	void NetRingEventHandler::Read(SocketContext& socketContext, uint32_t bytesTransferred)
+	{
+		socketContext.receiveRing.Commit(bytesTransferred);
+		ParseRing(socketContext);
+		SetNextReceive(socketContext);
+	}
+
+	void NetRingEventHandler::ReadProvided(SocketContext& socketContext, char* buffer, uint32_t bytesTransferred)
+	{
+		NetReceiveRing& receiveRing = socketContext.receiveRing;
+		NetConnection& connection = *socketContext.connection;
+
+		// Complete frames are delivered straight from the kernel-selected buffer, only the incomplete tail goes to the ring
+		const char* data = buffer;
+		size_t size = bytesTransferred;
+		if (receiveRing.Empty())
+		{
+			while (size >= NetProtocolFramedTCP::headerSize)
+			{
+				uint32_t messageSize = NetProtocolFramedTCP::DecodeHeader(data);
+				// Oversized frames are rejected by ParseRing
+				if (messageSize > GetMaxMessageSize() || size - NetProtocolFramedTCP::headerSize < messageSize) break;
+
+				connection.ReceiveView(NetMessageView(data + NetProtocolFramedTCP::headerSize, messageSize));
+				LENET_LOG_DEBUG(IO, "[msg end]");
+				data += NetProtocolFramedTCP::headerSize + messageSize;
+				size -= NetProtocolFramedTCP::headerSize + messageSize;
+			}
+		}
+
+		if (size != 0 && !receiveRing.IsAttached()) { receiveRing.Attach(ringPool.TakeBuffer(), ringPool.size); }
+		while (size != 0)
+		{
+			size_t copied = receiveRing.Append(data, size);
+			// Only a malformed stream is left undrained
+			if (copied == 0) break;
+			data += copied;
+			size -= copied;
+			ParseRing(socketContext);
+		}
+		GetBufferPool().ReturnBuffer(buffer);
+	}
+
+	void NetRingEventHandler::ParseRing(SocketContext& socketContext)
+	{
+		NetConnection& connection = *socketContext.connection;
+		bool isValid = socketContext.receiveRing.ParseFrames(wrapScratch, [&connection](NetMessageView message) {
+			connection.ReceiveView(message);
+			LENET_LOG_DEBUG(IO, "[msg end]");
+		}, GetMaxMessageSize());
+		// The next receive then reports the disconnect and the event manager removes the connection
+		if (!isValid) { socketContext.socket.Shutdown(); }
+	}
+
+	void NetRingEventHandler::SetNextReceive(SocketContext& socketContext)
+	{
+		auto [region, regionSize] = socketContext.receiveRing.WritableRegion();
+		socketContext.receiveContext.netBuffer.buf = region;
+		socketContext.receiveContext.SetMessageLength(regionSize);
+	}
+
+	bool NetRingEventHandler::Disconnect(SocketContext& socketContext)
+	{
+		if (socketContext.receiveRing.IsAttached()) { ringPool.ReturnBuffer(socketContext.receiveRing.Detach()); }
+		return NetFramedEventHandler::Disconnect(socketContext);
+	}
+}
@@ -0,0 +1,34 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include "NetFramedEventHandler.hpp"
+
+namespace LimeEngine::Net
+{
+	// Zero-copy receive for NetProtocolFramedTCP. Every connection reads into its own NetReceiveRing
+	// and messages are passed to NetConnection::ReceiveView as views into the ring. Sending is the same as NetFramedEventHandler.
+	class NetRingEventHandler : public NetFramedEventHandler
+	{
+	public:
+		static constexpr size_t ringSize = 16ull * 1024ull;
+
+		NetRingEventHandler() = default;
+		// Rings come from slabs as well, only hugePages applies to them
+		explicit NetRingEventHandler(const SlabOptions& slabOptions);
+
+		void StartRead(SocketContext& socketContext);
+		void Read(SocketContext& socketContext, uint32_t bytesTransferred);
+		void ReadProvided(SocketContext& socketContext, char* buffer, uint32_t bytesTransferred);
+
+		bool Disconnect(SocketContext& socketContext);
+
+	private:
+		void ParseRing(SocketContext& socketContext);
+		void SetNextReceive(SocketContext& socketContext);
+
+	private:
+		BufferPool<ringSize> ringPool;
+		std::string wrapScratch;
+	};
+}
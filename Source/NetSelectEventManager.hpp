@@ -3,6 +3,7 @@
 
 #pragma once
 #include "NetBufferBasedEventManager.hpp"
+#include "NetWakeup.hpp"
 
 namespace LimeEngine::Net
 {
@@ -43,14 +44,24 @@ namespace LimeEngine::Net
 		bool excepted;
 	};
 
+	// The wakeup handle is selected for reading next to the sockets, but isn't one of them
 	class NetSelectBuffer
 	{
 	public:
-		NetSelectBuffer() noexcept
+		static constexpr bool edgeTriggered = false;
+
+		NetSelectBuffer()
 		{
 			FD_ZERO(&readFDs);
 			FD_ZERO(&writeFDs);
 			FD_ZERO(&exceptFDs);
+
+			NativeSocket wakeupFD = wakeup.GetNativeHandle();
+			FD_SET(wakeupFD, &readFDs);
+			FD_SET(wakeupFD, &exceptFDs);
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+			largestSocket = wakeupFD;
+#endif
 		}
 		bool Add(NativeSocket fd)
 		{
@@ -64,7 +75,7 @@ namespace LimeEngine::Net
 			//FD_SET(fd, &writeFDs);
 			FD_SET(fd, &exceptFDs);
 
-#ifndef LENET_WIN32
+#ifndef LE_BUILD_PLATFORM_WINDOWS
 			if (fd > largestSocket) { largestSocket = fd; }
 #endif
 			sockets.emplace_back(fd);
@@ -77,10 +88,19 @@ namespace LimeEngine::Net
 			FD_CLR(fd, &writeFDs);
 			FD_CLR(fd, &exceptFDs);
 
-#ifndef LENET_WIN32
-			if (largestSocket == fd) { largestSocket = *std::max_element(std::begin(sockets), std::end(sockets)); }
+			// The last socket takes the place of the removed one
+			sockets[index] = sockets.back();
+			sockets.pop_back();
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+			// Every socket is in exceptFDs (readFDs loses paused ones), the scan is bounded by FD_SETSIZE rather than the number of sockets
+			if (largestSocket == fd)
+			{
+				while (largestSocket > 0 && !FD_ISSET(largestSocket, &exceptFDs))
+				{
+					--largestSocket;
+				}
+			}
 #endif
-			sockets.erase(std::begin(sockets) + index);
 		}
 		int WaitForEvents(uint32_t timeout)
 		{
@@ -88,27 +108,52 @@ namespace LimeEngine::Net
 			writeFDsCopy = writeFDs;
 			exceptFDsCopy = exceptFDs;
 
-			// TODO: add timeout
 			timeval tv;
-			tv.tv_sec = 0;
-			tv.tv_usec = timeout;
+			tv.tv_sec = static_cast<long>(timeout / 1000u);
+			tv.tv_usec = static_cast<long>((timeout % 1000u) * 1000u);
 
-			int result = select(largestSocket, &readFDsCopy, &writeFDsCopy, &exceptFDsCopy, &tv);
+			int result = select(largestSocket + 1, &readFDsCopy, &writeFDsCopy, &exceptFDsCopy, &tv);
 			if (result < 0)
 			{
-				// EWOULDBLOCK
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+				if (errno == EINTR) return 0;
+#endif
 				LENET_LAST_ERROR_MSG("Can't to select");
-				return false;
+				return 0;
+			}
+			if (FD_ISSET(wakeup.GetNativeHandle(), &readFDsCopy))
+			{
+				wakeup.Drain();
+				--result;
 			}
 			return result;
 		}
 
+		// Any thread, interrupts the current or the next wait
+		void Wake()
+		{
+			wakeup.Signal();
+		}
+
 		SelectFD At(size_t index)
 		{
 			NativeSocket fd = sockets[index];
 			return SelectFD{ fd, static_cast<bool>(FD_ISSET(fd, &readFDsCopy)), static_cast<bool>(FD_ISSET(fd, &writeFDsCopy)), static_cast<bool>(FD_ISSET(fd, &exceptFDsCopy)) };
 		}
 
+		size_t EventsCount() const
+		{
+			return sockets.size();
+		}
+		size_t EventSocketIndex(size_t eventIndex) const
+		{
+			return eventIndex;
+		}
+		SelectFD EventAt(size_t eventIndex)
+		{
+			return At(eventIndex);
+		}
+
 		size_t Count() const
 		{
 			return sockets.size();
@@ -117,6 +162,14 @@ namespace LimeEngine::Net
 		{
 			return sockets.empty();
 		}
+		void SetReadFlag(size_t index)
+		{
+			FD_SET(sockets[index], &readFDs);
+		}
+		void ResetReadFlag(size_t index)
+		{
+			FD_CLR(sockets[index], &readFDs);
+		}
 		void SetWriteFlag(size_t index)
 		{
 			FD_SET(sockets[index], &writeFDs);
@@ -147,10 +200,11 @@ namespace LimeEngine::Net
 				oss << ((FD_ISSET(socket, &exceptFDsCopy)) ? "E" : "");
 				oss << ']';
 			}
-			NetLogger::LogCore(oss.str());
+			LENET_LOG_TRACE(Poll, oss.str());
 		}
 
 	private:
+		NetWakeup wakeup;
 		std::vector<NativeSocket> sockets;
 		//std::array<NetSocket, FD_SETSIZE> sockets;
 
@@ -162,7 +216,7 @@ namespace LimeEngine::Net
 		fd_set writeFDsCopy;
 		fd_set exceptFDsCopy;
 
-#ifdef LENET_WIN32
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		// Windows ignores nfds
 		static constexpr int largestSocket = FD_SETSIZE;
 #else
@@ -0,0 +1,98 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <array>
+#include <string>
+#include "Protocols/NetProtocolFramedTCP.hpp"
+
+namespace LimeEngine::Net
+{
+	// Several queued messages gathered into one vectored send. Every framed message takes two buffers, its header and its payload,
+	// so the payload is sent from the message itself without being copied. Partial sends advance across message boundaries.
+	class NetSendBatch
+	{
+	public:
+		static constexpr size_t maxMessages = 32;
+
+		bool Empty() const noexcept
+		{
+			return firstBuffer == bufferCount;
+		}
+		bool Full() const noexcept
+		{
+			return messageCount == maxMessages;
+		}
+
+		void AddFramed(const std::string& message) noexcept
+		{
+			char* header = headers[messageCount].data();
+			NetProtocolFramedTCP::EncodeHeader(header, static_cast<uint32_t>(message.size()));
+			AddBuffer(header, NetProtocolFramedTCP::headerSize);
+			// Empty payloads end with the header
+			if (!message.empty()) AddBuffer(const_cast<char*>(message.data()), static_cast<uint32_t>(message.size()));
+			lastBuffers[messageCount++] = bufferCount - 1;
+		}
+
+		// Skips sent bytes, returns the number of messages that were sent completely
+		size_t Advance(size_t bytesTransferred) noexcept
+		{
+			size_t sentMessages = 0;
+			while (bytesTransferred != 0 && firstBuffer != bufferCount)
+			{
+				NetBuffer& netBuffer = buffers[firstBuffer];
+				if (bytesTransferred < netBuffer.len)
+				{
+					netBuffer.buf += bytesTransferred;
+					netBuffer.len -= static_cast<uint32_t>(bytesTransferred);
+					break;
+				}
+
+				bytesTransferred -= netBuffer.len;
+				if (firstBuffer == lastBuffers[sentMessageCount])
+				{
+					++sentMessageCount;
+					++sentMessages;
+				}
+				++firstBuffer;
+			}
+			if (Empty()) Clear();
+			return sentMessages;
+		}
+
+		// Buffers that are not sent yet
+		NetBuffer* Buffers() noexcept
+		{
+			return buffers.data() + firstBuffer;
+		}
+		uint32_t BufferCount() const noexcept
+		{
+			return static_cast<uint32_t>(bufferCount - firstBuffer);
+		}
+
+		void Clear() noexcept
+		{
+			firstBuffer = 0;
+			bufferCount = 0;
+			messageCount = 0;
+			sentMessageCount = 0;
+		}
+
+	private:
+		void AddBuffer(char* buf, uint32_t len) noexcept
+		{
+			buffers[bufferCount].buf = buf;
+			buffers[bufferCount].len = len;
+			++bufferCount;
+		}
+
+	private:
+		std::array<NetBuffer, maxMessages * 2> buffers;
+		std::array<std::array<char, NetProtocolFramedTCP::headerSize>, maxMessages> headers;
+		std::array<size_t, maxMessages> lastBuffers;
+		size_t firstBuffer = 0;
+		size_t bufferCount = 0;
+		size_t messageCount = 0;
+		size_t sentMessageCount = 0;
+	};
+}
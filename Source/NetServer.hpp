@@ -2,130 +2,562 @@
 // See the LICENSE file for copyright and licensing details.
 
 #pragma once
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 #include "NetEventHandler.hpp"
+#include "NetConnectionHandler.hpp"
+#include "SPSCQueue.hpp"
+#include "MPSCQueue.hpp"
+#include "SlotMap.hpp"
+#include "NetMetrics.hpp"
+#include "NetWaitStrategy.hpp"
 
 namespace LimeEngine::Net
 {
-	template <typename TNetEventManager>
+	enum class NetDispatchMode : uint8_t
+	{
+		// Handlers run when NetServer::Update is called, e.g. once per frame of the application
+		Deferred,
+		// Handlers run in NetServer::HandleNetEvents as soon as the event manager has completed the messages, in the order they completed
+		Inline
+	};
+
+	// Message sent from outside the worker's thread, queued until the worker looks its connection up
+	struct NetPostedMessage
+	{
+		NetConnectionId id = 0;
+		std::string message;
+	};
+
+	// Event manager together with the connections it serves, optionally running on its own thread
+	template <typename TNetEventManager, NetConnectionHandler THandler = NetFunctionHandler>
+	class NetServerWorker
+	{
+	private:
+		static constexpr uint32_t idleListenTimeout = 100u;
+		// Upper bound of a wait while connections are open, new sockets are only picked up between waits
+		static constexpr uint32_t maxWaitTimeout = 10u;
+
+	public:
+		NetServerWorker(const NetServerWorker& other) = delete;
+		NetServerWorker operator=(const NetServerWorker& other) = delete;
+
+		// Connection ids are tagged with the worker index, so they are unique across the server
+		template <typename... TArgs>
+		explicit NetServerWorker(uint8_t workerIndex, THandler& handler, TArgs&&... args) :
+			handler(handler), netEventManager(std::forward<TArgs>(args)...), connections(workerIndex), workerIndex(workerIndex)
+		{}
+		~NetServerWorker()
+		{
+			Stop();
+			// Connections closed since the last Update still get their disconnect
+			connections.EraseIf([this](NetConnection& connection) {
+				connection.DispatchDisconnect(handler);
+				return true;
+			});
+		}
+
+		void AddConnection(NetSocket&& socket)
+		{
+			connectionCount.fetch_add(1, std::memory_order_relaxed);
+			OpenConnection(std::move(socket));
+		}
+
+		// Called from the acceptor thread while the worker thread is running
+		bool HandOff(NetSocket&& socket)
+		{
+			if (!pendingSockets.Push(socket.GetNativeSocket())) return false;
+			socket.Release();
+			connectionCount.fetch_add(1, std::memory_order_relaxed);
+			Wake();
+			return true;
+		}
+
+		// Any thread. The message goes out from the worker's thread, it is dropped if the connection is closed by then.
+		void PostSend(NetConnectionId id, std::string message)
+		{
+			NetMetrics::Add(NetCounter::PostedSends);
+			postedMessages.Push(NetPostedMessage{ id, std::move(message) });
+			netEventManager.Wake();
+		}
+
+		// Only visits the connections that received messages or were closed since the last call
+		void Update()
+		{
+			size_t closedCount = 0;
+			readyList.Drain([this, &closedCount](NetConnectionId id) {
+				NetConnection* connection = connections.Get(id);
+				if (connection == nullptr || connection->Update(handler)) return;
+				connections.Erase(id);
+				++closedCount;
+			});
+			if (closedCount != 0)
+			{
+				connectionCount.fetch_sub(closedCount, std::memory_order_relaxed);
+				NetMetrics::Add(NetCounter::Disconnects, closedCount);
+				NetMetrics::Add(NetGauge::Connections, -static_cast<int64_t>(closedCount));
+			}
+		}
+
+		// Waits for at most maxTimeout, less if a timer is due earlier
+		void HandleNetEvents(uint32_t maxTimeout)
+		{
+			WaitForEvents(timers.NextTimeout(maxTimeout));
+			timers.Advance();
+			if (dispatchMode == NetDispatchMode::Inline) Update();
+		}
+
+		// Worker threads always dispatch right after handling their events
+		void SetDispatchMode(NetDispatchMode mode) noexcept
+		{
+			dispatchMode = mode;
+		}
+
+		// Only to be changed while the worker thread is stopped
+		void SetWaitStrategy(const NetWaitOptions& options) noexcept
+		{
+			waitStrategy = NetWaitStrategy(options);
+		}
+
+		// Opens a listener of its own, the kernel spreads incoming connections across every SO_REUSEPORT socket bound to the address
+		void Listen(NetSocketIPv4Address address)
+		{
+#ifndef SO_REUSEPORT
+			LENET_MSG_ERROR("Sharded listeners require SO_REUSEPORT");
+#endif
+			listenSocket = NetSocket(NetAddressType::IPv4);
+			listenSocket.SetReuseAddr();
+			listenSocket.SetNonblockingMode();
+			listenSocket.Bind(address);
+			listenSocket.Listen();
+		}
+
+		void DisconnectAll()
+		{
+			netEventManager.DisconnectAllConnections();
+		}
+
+		void Start()
+		{
+			if (IsRunning()) return;
+			running.store(true, std::memory_order_release);
+			thread = std::thread(&NetServerWorker::Run, this);
+		}
+		void Stop()
+		{
+			if (!IsRunning()) return;
+			running.store(false, std::memory_order_release);
+			Wake();
+			thread.join();
+		}
+		bool IsRunning() const
+		{
+			return thread.joinable();
+		}
+
+		size_t NumberOfConnections() const
+		{
+			return connectionCount.load(std::memory_order_relaxed);
+		}
+		SlotMap<NetConnection>& GetConnections()
+		{
+			return connections;
+		}
+		// Timers of the worker's event loop, only to be used from the worker thread once it is running
+		NetTimerWheel& GetTimers()
+		{
+			return timers;
+		}
+
+	private:
+		void Run()
+		{
+			NetMetrics::SetThreadName(std::format("worker {}", workerIndex));
+			while (running.load(std::memory_order_acquire))
+			{
+				uint32_t wakeValue = wakeCounter.load(std::memory_order_acquire);
+				AcceptPending();
+				AcceptListening();
+
+				bool hasConnections = netEventManager.HasConnections();
+				if (hasConnections) WaitForEvents(timers.NextTimeout(maxWaitTimeout));
+				else SendPosted();
+				timers.Advance();
+				Update();
+
+				// Sleep until a new connection arrives or a timer is due instead of spinning on an empty event manager
+				if (!hasConnections && pendingSockets.Empty())
+				{
+					if (listenSocket.IsValid()) { listenSocket.WaitForRead(timers.NextTimeout(idleListenTimeout)); }
+					else { WaitForWake(wakeValue); }
+				}
+			}
+			AcceptPending();
+			listenSocket.Close();
+		}
+
+		// Returns once Wake has been called since wakeValue was read or the next timer is due
+		void WaitForWake(uint32_t wakeValue)
+		{
+			std::unique_lock lock(wakeMutex);
+			auto woken = [this, wakeValue]() { return wakeCounter.load(std::memory_order_acquire) != wakeValue; };
+			if (timers.Empty()) { wakeCondition.wait(lock, woken); }
+			else { wakeCondition.wait_for(lock, std::chrono::milliseconds(timers.NextTimeout(maxWaitTimeout)), woken); }
+		}
+
+		bool WaitForEvents(uint32_t timeout)
+		{
+			return waitStrategy.Wait(timeout, [this](uint32_t waitTimeout) {
+				// Before every wait, so a spinning or busy polling loop picks posted messages up as soon as a blocking one would be woken
+				SendPosted();
+				return netEventManager.HandleNetEvents(waitTimeout);
+			});
+		}
+
+		void SendPosted()
+		{
+			NetPostedMessage posted;
+			while (postedMessages.Pop(posted))
+			{
+				NetConnection* connection = connections.Get(posted.id);
+				if (connection != nullptr) connection->Send(posted.message);
+			}
+		}
+
+		void AcceptListening()
+		{
+			if (!listenSocket.IsValid()) return;
+
+			NetSocket clientSocket;
+			while (listenSocket.Accept(clientSocket))
+			{
+				NetMetrics::Add(NetCounter::Accepts);
+				AddConnection(std::move(clientSocket));
+			}
+		}
+
+		void OpenConnection(NetSocket&& socket)
+		{
+			NetConnectionId id = connections.Emplace();
+			if (id == SlotMap<NetConnection>::invalidHandle)
+			{
+				LENET_MSG_ERROR("Too many connections");
+				connectionCount.fetch_sub(1, std::memory_order_relaxed);
+				return;
+			}
+			NetMetrics::Add(NetGauge::Connections, 1);
+			auto& connection = *connections.Get(id);
+			if (waitStrategy.GetOptions().socketBusyPoll != 0) socket.SetBusyPoll(waitStrategy.GetOptions().socketBusyPoll);
+			connection.AttachTimers(&timers);
+			connection.AttachReadyList(&readyList);
+			if constexpr (NetMessageViewHandler<THandler>) { connection.AttachViewHandler(&handler, &DispatchMessageView<THandler>); }
+			if constexpr (NetSendPressureHandler<THandler>) { connection.AttachSendPressureHandler(&handler, &DispatchSendPressure<THandler>); }
+			netEventManager.AddConnection(std::move(socket), connection);
+			handler.OnConnection(connection);
+		}
+
+		void AcceptPending()
+		{
+			NativeSocket nativeSocket;
+			while (pendingSockets.Pop(nativeSocket))
+			{
+				OpenConnection(NetSocket(nativeSocket));
+			}
+		}
+
+		void Wake()
+		{
+			{
+				// Under the mutex, so a worker between checking the counter and waiting can't miss the change
+				std::lock_guard lock(wakeMutex);
+				wakeCounter.fetch_add(1, std::memory_order_release);
+			}
+			wakeCondition.notify_one();
+			// A worker with connections sleeps in the event manager instead
+			netEventManager.Wake();
+		}
+
+	private:
+		THandler& handler;
+		TNetEventManager netEventManager;
+		// Declared before the connections, which cancel their timers when they are destroyed
+		NetTimerWheel timers;
+		NetReadyList readyList;
+		SlotMap<NetConnection> connections;
+		std::atomic<size_t> connectionCount = 0;
+
+		NetSocket listenSocket;
+		SPSCQueue<NativeSocket, 1024> pendingSockets;
+		MPSCQueue<NetPostedMessage> postedMessages;
+		std::atomic<uint32_t> wakeCounter = 0;
+		std::mutex wakeMutex;
+		std::condition_variable wakeCondition;
+		std::atomic<bool> running = false;
+		std::thread thread;
+		NetDispatchMode dispatchMode = NetDispatchMode::Deferred;
+		NetWaitStrategy waitStrategy;
+		uint8_t workerIndex;
+	};
+
+	// Connection events go to THandler, see NetConnectionHandler. The default NetFunctionHandler takes std::function callbacks.
+	template <typename TNetEventManager, NetConnectionHandler THandler = NetFunctionHandler>
 	class NetServer
 	{
+	private:
+		static constexpr size_t maxWorkers = 256;
+
 	public:
 		NetServer(const NetServer& other) = delete;
 		NetServer operator=(const NetServer& other) = delete;
 
 		template <typename TNetEventHandler = NetEventHandler>
-		explicit NetServer(TNetEventHandler&& netEventHandler, NetSocketIPv4Address address) : serverSocket(NetAddressType::IPv4)
+		explicit NetServer(TNetEventHandler&& netEventHandler, NetSocketIPv4Address address) : address(address), serverSocket(NetAddressType::IPv4)
 		{
 			serverSocket.SetNonblockingMode();
 			serverSocket.Bind(address);
 			serverSocket.Listen();
 
-			netEventManagers.emplace_back(std::forward<TNetEventHandler>(netEventHandler));
+			AddEventHandler(std::forward<TNetEventHandler>(netEventHandler));
 		}
-		explicit NetServer(NetSocketIPv4Address address) : serverSocket(NetAddressType::IPv4)
+		explicit NetServer(NetSocketIPv4Address address) : address(address), serverSocket(NetAddressType::IPv4)
 		{
 			serverSocket.SetNonblockingMode();
 			serverSocket.Bind(address);
 			serverSocket.Listen();
 
-			netEventManagers.emplace_back();
+			AddEventHandler();
+		}
+		explicit NetServer(NetSocketIPv4Address address, THandler handler) :
+			address(address), serverSocket(NetAddressType::IPv4), handler(std::move(handler))
+		{
+			serverSocket.SetNonblockingMode();
+			serverSocket.Bind(address);
+			serverSocket.Listen();
+
+			AddEventHandler();
+		}
+		~NetServer()
+		{
+			StopThreads();
 		}
 
 		template <typename TNetEventHandler = NetEventHandler>
 		void AddEventHandler(TNetEventHandler&& netEventHandler)
 		{
-			netEventManagers.emplace_back(std::forward<TNetEventHandler>(netEventHandler));
+			if (workers.size() == maxWorkers)
+			{
+				LENET_MSG_ERROR("Too many event handlers");
+				return;
+			}
+			workers.emplace_back(
+				std::make_unique<NetServerWorker<TNetEventManager, THandler>>(static_cast<uint8_t>(workers.size()), handler, std::forward<TNetEventHandler>(netEventHandler)));
+			workers.back()->SetDispatchMode(dispatchMode);
+			workers.back()->SetWaitStrategy(waitOptions);
 		}
 		void AddEventHandler()
 		{
-			netEventManagers.emplace_back();
+			if (workers.size() == maxWorkers)
+			{
+				LENET_MSG_ERROR("Too many event handlers");
+				return;
+			}
+			workers.emplace_back(std::make_unique<NetServerWorker<TNetEventManager, THandler>>(static_cast<uint8_t>(workers.size()), handler));
+			workers.back()->SetDispatchMode(dispatchMode);
+			workers.back()->SetWaitStrategy(waitOptions);
 		}
 
+		// Deferred by default. Has no effect on worker threads, which dispatch after every wait.
+		void SetDispatchMode(NetDispatchMode mode)
+		{
+			dispatchMode = mode;
+			for (auto& worker : workers)
+			{
+				worker->SetDispatchMode(mode);
+			}
+		}
+
+		// Blocking by default, applies to every worker. Must be set before the threads are started.
+		void SetWaitStrategy(const NetWaitOptions& options)
+		{
+			waitOptions = options;
+			for (auto& worker : workers)
+			{
+				worker->SetWaitStrategy(options);
+			}
+		}
+
+		// Runs every event manager on its own thread, Accept() then only hands sockets over to them.
+		// Connection callbacks are invoked on the thread of the event manager that owns the connection.
+		void StartThreads()
+		{
+			for (auto& worker : workers)
+			{
+				worker->Start();
+			}
+		}
+		// Shared-nothing mode: every worker accepts on its own SO_REUSEPORT listener and keeps its connections,
+		// event manager and buffer pool to itself, there is no acceptor thread and no cross-thread handoff.
+		void StartSharded()
+		{
+			serverSocket.Close();
+			for (auto& worker : workers)
+			{
+				worker->Listen(address);
+			}
+			StartThreads();
+		}
+		void StopThreads()
+		{
+			for (auto& worker : workers)
+			{
+				worker->Stop();
+			}
+		}
+		bool IsThreaded() const
+		{
+			return !workers.empty() && workers.front()->IsRunning();
+		}
+
+		// Runs the handlers of the messages received since the last call, only needed in NetDispatchMode::Deferred
 		void Update()
 		{
-			for (auto connectionIter = connections.begin(); connectionIter != connections.end();)
+			if (IsThreaded()) return;
+			for (auto& worker : workers)
 			{
-				if (!connectionIter->Update())
-				{
-					connectionIter = connections.erase(connectionIter);
-				}
-				else
-				{
-					++connectionIter;
-				}
+				worker->Update();
 			}
 		}
 
 		void Accept()
 		{
+			if (!serverSocket.IsValid()) return;
+
 			NetSocket clientSocket;
-			if (serverSocket.Accept(clientSocket)) { AddConnection(std::move(clientSocket)); }
+			if (serverSocket.Accept(clientSocket))
+			{
+				NetMetrics::Add(NetCounter::Accepts);
+				AddConnection(std::move(clientSocket));
+			}
 		}
 
-		void HandleNetEvents()
+		// Every worker waits for at most maxTimeout, less if one of its timers is due earlier
+		void HandleNetEvents(uint32_t maxTimeout = 1u)
 		{
+			if (IsThreaded()) return;
+
 			int index = 0;
-			for (auto& handler : netEventManagers)
+			for (auto& worker : workers)
 			{
-				NetLogger::LogCore("Handler({})", index++);
+				LENET_LOG_TRACE(Poll, "Handler({})", index++);
 
-				handler.HandleNetEvents();
+				worker->HandleNetEvents(maxTimeout);
 			}
 		}
 
 		void DisconnectAll()
 		{
-			for (auto& handler : netEventManagers)
+			StopThreads();
+			for (auto& worker : workers)
 			{
-				handler.DisconnectAllConnections();
+				worker->DisconnectAll();
 			}
 		}
 
 		bool HasConnections() const
 		{
-			return !connections.empty();
+			return NumberOfConnections() != 0;
 		}
 		size_t NumberOfConnections() const
 		{
-			return connections.size();
+			size_t count = 0;
+			for (auto& worker : workers)
+			{
+				count += worker->NumberOfConnections();
+			}
+			return count;
 		}
-		std::list<NetConnection>& GetConnections()
+		// Returns nullptr if the index is out of range. Not synchronized with worker threads.
+		NetConnection* GetConnection(size_t index)
 		{
-			return connections;
+			for (auto& worker : workers)
+			{
+				auto& connections = worker->GetConnections();
+				if (index < connections.Size()) return &connections.At(index);
+				index -= connections.Size();
+			}
+			return nullptr;
+		}
+		// Timers of one worker, they run on its thread and may only be used there while threads are running
+		NetTimerWheel& GetTimers(size_t workerIndex = 0)
+		{
+			return workers[workerIndex]->GetTimers();
+		}
+		// Thread-safe, unlike NetConnection::Send: queues the message for the worker that owns the connection and wakes it.
+		// Returns false if the id can't belong to any worker, messages for connections that are closed by the time they are handled are dropped.
+		bool Send(NetConnectionId id, std::string message)
+		{
+			uint8_t workerIndex = SlotMap<NetConnection>::TagOf(id);
+			if (workerIndex >= workers.size()) return false;
+			workers[workerIndex]->PostSend(id, std::move(message));
+			return true;
+		}
+		// Returns nullptr for ids of closed connections. Not synchronized with worker threads.
+		NetConnection* FindConnection(NetConnectionId id)
+		{
+			uint8_t workerIndex = SlotMap<NetConnection>::TagOf(id);
+			if (workerIndex >= workers.size()) return nullptr;
+			return workers[workerIndex]->GetConnections().Get(id);
 		}
 
 	public:
-		void OnConnection(const std::function<void(NetConnection&)>& handler)
+		void OnConnection(const std::function<void(NetConnection&)>& onConnection)
+			requires std::same_as<THandler, NetFunctionHandler>
+		{
+			handler.onConnection = onConnection;
+		}
+		// Shared by every worker, only to be changed while no worker thread is running
+		THandler& GetHandler() noexcept
 		{
-			onConnection = handler;
+			return handler;
 		}
 
 	private:
 		void AddConnection(NetSocket&& socket)
 		{
-			connections.emplace_back();
-			auto& connection = connections.back();
-			GetAvailableEventHandler().AddConnection(std::move(socket), connection);
-			onConnection(connection);
+			auto& worker = GetAvailableWorker();
+			if (!worker.IsRunning())
+			{
+				worker.AddConnection(std::move(socket));
+				return;
+			}
+			while (!worker.HandOff(std::move(socket)))
+			{
+				std::this_thread::yield();
+			}
 		}
-		TNetEventManager& GetAvailableEventHandler()
+		NetServerWorker<TNetEventManager, THandler>& GetAvailableWorker()
 		{
-			auto& availableHandler = netEventManagers[availableServerIndex];
+			auto& availableWorker = *workers[availableServerIndex];
 
-			size_t newAvailableServerIndex = (availableServerIndex + 1ull) % netEventManagers.size();
-			if (availableHandler.NumberOfConnections() > netEventManagers[newAvailableServerIndex].NumberOfConnections())
+			size_t newAvailableServerIndex = (availableServerIndex + 1ull) % workers.size();
+			if (availableWorker.NumberOfConnections() > workers[newAvailableServerIndex]->NumberOfConnections())
 			{
 				availableServerIndex = newAvailableServerIndex;
 			}
-			return availableHandler;
+			return availableWorker;
 		}
 
 	private:
+		NetSocketIPv4Address address;
 		NetSocket serverSocket;
-		std::list<NetConnection> connections;
-		std::vector<TNetEventManager> netEventManagers;
+		// Declared before the workers, which use it until they are destroyed
+		THandler handler;
+		std::vector<std::unique_ptr<NetServerWorker<TNetEventManager, THandler>>> workers;
+		NetDispatchMode dispatchMode = NetDispatchMode::Deferred;
+		NetWaitOptions waitOptions;
 		size_t availableServerIndex = 0ull;
-
-		std::function<void(NetConnection&)> onConnection;
 	};
 }
@@ -2,12 +2,50 @@
 // See the LICENSE file for copyright and licensing details.
 
 #include "NetSockets.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace LimeEngine::Net
 {
+	namespace
+	{
+		bool IsWouldBlockError(int err) noexcept
+		{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+			return err == WSAEWOULDBLOCK;
+#else
+			return err == EWOULDBLOCK || err == EAGAIN;
+#endif
+		}
+
+		bool IsConnectionClosedError(int err) noexcept
+		{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+			return err == WSAECONNRESET;
+#else
+			return err == ECONNRESET || err == EPIPE;
+#endif
+		}
+
+		// ICMP errors of earlier datagrams to a closed port or a dead host, they say nothing about the socket itself
+		bool IsPeerUnreachableError(int err) noexcept
+		{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+			return err == WSAECONNRESET || err == WSAENETRESET || err == WSAEHOSTUNREACH || err == WSAENETUNREACH;
+#else
+			return err == ECONNREFUSED || err == EHOSTUNREACH || err == ENETUNREACH;
+#endif
+		}
+
+		int ProtocolOf(NetSocketType socketType) noexcept
+		{
+			return socketType == NetSocketType::Datagram ? IPPROTO_UDP : IPPROTO_TCP;
+		}
+	}
+
 	NetSocket::NetSocket(NetSocket&& socket) noexcept : _socket(socket._socket)
 	{
-		socket._socket = INVALID_SOCKET;
+		socket._socket = InvalidNativeSocket;
 	}
 
 	NetSocket& NetSocket::operator=(NetSocket&& socket) noexcept
@@ -15,15 +53,22 @@ namespace LimeEngine::Net
 		if (&socket != this)
 		{
 			_socket = socket._socket;
-			socket._socket = INVALID_SOCKET;
+			socket._socket = InvalidNativeSocket;
 		}
 		return *this;
 	}
 
-	NetSocket::NetSocket(NetAddressType addressType, bool async) :
-		_socket(WSASocketW(static_cast<int>(addressType), SOCK_STREAM, IPPROTO_TCP, nullptr, 0, async ? WSA_FLAG_OVERLAPPED : 0))
+	NetSocket::NetSocket(NetAddressType addressType, bool async) : NetSocket(addressType, NetSocketType::Stream, async) {}
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	NetSocket::NetSocket(NetAddressType addressType, NetSocketType socketType, bool async) :
+		_socket(WSASocketW(static_cast<int>(addressType), static_cast<int>(socketType), ProtocolOf(socketType), nullptr, 0, async ? WSA_FLAG_OVERLAPPED : 0))
+#else
+	NetSocket::NetSocket(NetAddressType addressType, NetSocketType socketType, [[maybe_unused]] bool async) :
+		_socket(socket(static_cast<int>(addressType), static_cast<int>(socketType) | SOCK_CLOEXEC, ProtocolOf(socketType)))
+#endif
 	{
-		if (_socket == INVALID_SOCKET) { LENET_LAST_ERROR_MSG("Can't create socket"); }
+		if (_socket == InvalidNativeSocket) { LENET_LAST_ERROR_MSG("Can't create socket"); }
 	}
 
 	NetSocket::~NetSocket()
@@ -33,48 +78,88 @@ namespace LimeEngine::Net
 
 	void NetSocket::SetNonblockingMode(bool isNonblockingMode)
 	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		unsigned long mode = isNonblockingMode;
-		if (ioctlsocket(_socket, FIONBIO, &mode) == SOCKET_ERROR) { LENET_LAST_ERROR_MSG("Can't set nonblocking mode"); }
+		if (ioctlsocket(_socket, FIONBIO, &mode) == NativeSocketError) { LENET_LAST_ERROR_MSG("Can't set nonblocking mode"); }
+#else
+		int flags = fcntl(_socket, F_GETFL, 0);
+		if (flags == NativeSocketError) { LENET_LAST_ERROR_MSG("Can't get socket flags"); }
+		flags = isNonblockingMode ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+		if (fcntl(_socket, F_SETFL, flags) == NativeSocketError) { LENET_LAST_ERROR_MSG("Can't set nonblocking mode"); }
+#endif
 	}
 
 	void NetSocket::SetReuseAddr(bool isReuseAddr)
 	{
-		const char mode = static_cast<char>(isReuseAddr);
-		if (setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &mode, sizeof(mode)) < 0) { LENET_LAST_ERROR_MSG("Can't set reuse addr mode"); }
+		const int mode = static_cast<int>(isReuseAddr);
+		if (setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&mode), sizeof(mode)) < 0) { LENET_LAST_ERROR_MSG("Can't set reuse addr mode"); }
 
 #ifdef SO_REUSEPORT
-		if (setsockopt(_socket, SOL_SOCKET, SO_REUSEPORT, &mode, sizeof(mode)) < 0) { LENET_LAST_ERROR_MSG("Can't set reuse port mode"); }
+		if (setsockopt(_socket, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&mode), sizeof(mode)) < 0) { LENET_LAST_ERROR_MSG("Can't set reuse port mode"); }
+#endif
+	}
+
+	void NetSocket::SetNoDelay(bool isNoDelay)
+	{
+		const int mode = static_cast<int>(isNoDelay);
+		if (setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&mode), sizeof(mode)) < 0) { LENET_LAST_ERROR_MSG("Can't set no delay mode"); }
+	}
+
+	bool NetSocket::SetBusyPoll(uint32_t microseconds)
+	{
+#ifdef SO_BUSY_POLL
+		const int value = static_cast<int>(microseconds);
+		if (setsockopt(_socket, SOL_SOCKET, SO_BUSY_POLL, reinterpret_cast<const char*>(&value), sizeof(value)) < 0)
+		{
+			LENET_LOG_DEBUG(IO, "Can't set busy poll for {}: {}", _socket, LENET_GET_LAST_ERROR());
+			return false;
+		}
+		return true;
+#else
+		return false;
 #endif
 	}
 
 	void NetSocket::Bind(NetSocketIPv4Address address)
 	{
-		if (bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR) { LENET_LAST_ERROR_MSG("Can't bind socket"); }
+		if (bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == NativeSocketError) { LENET_LAST_ERROR_MSG("Can't bind socket"); }
 	}
 
 	void NetSocket::Listen()
 	{
-		if (listen(_socket, SOMAXCONN) == SOCKET_ERROR) { LENET_LAST_ERROR_MSG("Can't start to listen"); }
+		if (listen(_socket, SOMAXCONN) == NativeSocketError) { LENET_LAST_ERROR_MSG("Can't start to listen"); }
 	}
 
 	void NetSocket::Listen(int maxClient) const
 	{
-		if (listen(_socket, SOMAXCONN_HINT(maxClient)) == SOCKET_ERROR) { LENET_LAST_ERROR_MSG("Can't start to listen"); }
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		if (listen(_socket, SOMAXCONN_HINT(maxClient)) == NativeSocketError) { LENET_LAST_ERROR_MSG("Can't start to listen"); }
+#else
+		if (listen(_socket, maxClient) == NativeSocketError) { LENET_LAST_ERROR_MSG("Can't start to listen"); }
+#endif
 	}
 
 	bool NetSocket::Accept(NetSocket& outSocket) const
 	{
 		sockaddr_in clientSocketAddr{};
-		int clientAddrSize = sizeof(clientSocketAddr);
 
-		SOCKET clientSocket = WSAAccept(_socket, reinterpret_cast<sockaddr*>(&clientSocketAddr), &clientAddrSize, nullptr, 0);
-		if (clientSocket == INVALID_SOCKET)
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		int clientAddrSize = sizeof(clientSocketAddr);
+		NativeSocket clientSocket = WSAAccept(_socket, reinterpret_cast<sockaddr*>(&clientSocketAddr), &clientAddrSize, nullptr, 0);
+#else
+		socklen_t clientAddrSize = sizeof(clientSocketAddr);
+		NativeSocket clientSocket = accept(_socket, reinterpret_cast<sockaddr*>(&clientSocketAddr), &clientAddrSize);
+#endif
+		if (clientSocket == InvalidNativeSocket)
 		{
-			int err = WSAGetLastError();
-			if (err != WSAEWOULDBLOCK) LENET_ERROR(err, "Can't accept connection");
+			int err = LENET_GET_LAST_ERROR();
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+			if (err == ECONNABORTED || err == EINTR) return false;
+#endif
+			if (!IsWouldBlockError(err)) LENET_ERROR(err, "Can't accept connection");
 			return false;
 		}
-		NetLogger::LogCore("Accept {}", clientSocket);
+		LENET_LOG_DEBUG(IO, "Accept {}", clientSocket);
 		outSocket.SetSocket(clientSocket);
 		return true;
 	}
@@ -83,35 +168,67 @@ namespace LimeEngine::Net
 	{
 		if (connect(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
 		{
-			int err = WSAGetLastError();
-			if (err != WSAEWOULDBLOCK) LENET_ERROR(err, "Can't connect to server");
+			int err = LENET_GET_LAST_ERROR();
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+			if (err == EINPROGRESS) return false;
+#endif
+			if (!IsWouldBlockError(err)) LENET_ERROR(err, "Can't connect to server");
 			return false;
 		}
 		return true;
 	}
 
+	bool NetSocket::WaitForRead(uint32_t timeout) const
+	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		WSAPOLLFD pollFD{ _socket, POLLRDNORM, 0 };
+		int result = WSAPoll(&pollFD, 1, static_cast<INT>(timeout));
+#else
+		pollfd pollFD{ _socket, POLLIN, 0 };
+		int result = poll(&pollFD, 1, static_cast<int>(timeout));
+#endif
+		return result > 0;
+	}
+
 	void NetSocket::Close()
 	{
-		if (_socket != INVALID_SOCKET)
+		if (_socket != InvalidNativeSocket)
 		{
-			NetLogger::LogCore("Close socket {}", _socket);
+			LENET_LOG_DEBUG(IO, "Close socket {}", _socket);
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 			closesocket(_socket);
-			_socket = INVALID_SOCKET;
+#else
+			close(_socket);
+#endif
+			_socket = InvalidNativeSocket;
 		}
 	}
 
 	void NetSocket::Shutdown()
 	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		shutdown(_socket, SD_BOTH);
+#else
+		shutdown(_socket, SHUT_RDWR);
+#endif
 	}
 
 	bool NetSocket::Send(const char* buf, int bufSize, int& outBytesTransferred) const
 	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		outBytesTransferred = send(_socket, buf, bufSize, 0);
-		if (outBytesTransferred == SOCKET_ERROR)
+#else
+		outBytesTransferred = static_cast<int>(send(_socket, buf, bufSize, MSG_NOSIGNAL));
+#endif
+		if (outBytesTransferred == NativeSocketError)
 		{
-			int err = WSAGetLastError();
-			if (err == WSAECONNRESET || err == WSAEWOULDBLOCK)
+			int err = LENET_GET_LAST_ERROR();
+			if (IsWouldBlockError(err))
+			{
+				outBytesTransferred = -1;
+				return false;
+			}
+			if (IsConnectionClosedError(err))
 			{
 				outBytesTransferred = 0;
 				return false;
@@ -123,10 +240,57 @@ namespace LimeEngine::Net
 		return true;
 	}
 
+	bool NetSocket::SendBuffers(NetBuffer* netBuffers, uint32_t netBufferCount, int& outBytesTransferred) const
+	{
+		if (netBufferCount == 1) return Send(netBuffers->buf, static_cast<int>(netBuffers->len), outBytesTransferred);
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		DWORD bytesSent = 0;
+		int result = WSASend(_socket, netBuffers, netBufferCount, &bytesSent, 0, nullptr, nullptr);
+		outBytesTransferred = (result == SOCKET_ERROR) ? SOCKET_ERROR : static_cast<int>(bytesSent);
+#else
+		std::array<iovec, maxSendBuffers> iovecs;
+		if (netBufferCount > iovecs.size()) netBufferCount = static_cast<uint32_t>(iovecs.size());
+		for (uint32_t i = 0; i < netBufferCount; ++i)
+		{
+			iovecs[i].iov_base = netBuffers[i].buf;
+			iovecs[i].iov_len = netBuffers[i].len;
+		}
+		msghdr message{};
+		message.msg_iov = iovecs.data();
+		message.msg_iovlen = netBufferCount;
+		outBytesTransferred = static_cast<int>(sendmsg(_socket, &message, MSG_NOSIGNAL));
+#endif
+		if (outBytesTransferred == NativeSocketError)
+		{
+			int err = LENET_GET_LAST_ERROR();
+			if (IsWouldBlockError(err))
+			{
+				outBytesTransferred = -1;
+				return false;
+			}
+			if (IsConnectionClosedError(err))
+			{
+				outBytesTransferred = 0;
+				return false;
+			}
+			LENET_ERROR(err, "Can't send message to Client");
+			return false;
+		}
+		if (outBytesTransferred == 0) return false;
+		return true;
+	}
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	bool NetSocket::SendAsync(NetBuffer* netBuffer, NativeIOContext* nativeIoContext)
+	{
+		return SendBuffersAsync(netBuffer, 1, nativeIoContext);
+	}
+
+	bool NetSocket::SendBuffersAsync(NetBuffer* netBuffers, uint32_t netBufferCount, NativeIOContext* nativeIoContext)
 	{
 		DWORD flags = 0;
-		if (WSASend(_socket, netBuffer, 1, nullptr, flags, nativeIoContext, nullptr) == SOCKET_ERROR)
+		if (WSASend(_socket, netBuffers, netBufferCount, nullptr, flags, nativeIoContext, nullptr) == SOCKET_ERROR)
 		{
 			int err = WSAGetLastError();
 			if (err == WSA_IO_PENDING) return true;
@@ -135,14 +299,20 @@ namespace LimeEngine::Net
 		}
 		return true;
 	}
+#endif
 
 	bool NetSocket::Receive(char* buf, int bufSize, int& outBytesTransferred) const
 	{
-		outBytesTransferred = recv(_socket, buf, bufSize, 0);
-		if (outBytesTransferred == SOCKET_ERROR)
+		outBytesTransferred = static_cast<int>(recv(_socket, buf, bufSize, 0));
+		if (outBytesTransferred == NativeSocketError)
 		{
-			int err = WSAGetLastError();
-			if (err == WSAECONNRESET || err == WSAEWOULDBLOCK)
+			int err = LENET_GET_LAST_ERROR();
+			if (IsWouldBlockError(err))
+			{
+				outBytesTransferred = -1;
+				return false;
+			}
+			if (IsConnectionClosedError(err))
 			{
 				outBytesTransferred = 0;
 				return false;
@@ -154,6 +324,7 @@ namespace LimeEngine::Net
 		return true;
 	}
 
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	bool NetSocket::ReceiveAsync(NetBuffer* netBuffer, NativeIOContext* nativeIoContext)
 	{
 		DWORD flags = 0;
@@ -166,6 +337,164 @@ namespace LimeEngine::Net
 		}
 		return true;
 	}
+#endif
+
+	bool NetSocket::ReceiveDatagrams(NetDatagram* datagrams, uint32_t count, uint32_t bufferSize, uint32_t& outCount) const
+	{
+		outCount = 0;
+		count = std::min(count, maxDatagramBatch);
+#ifdef LE_BUILD_PLATFORM_LINUX
+		std::array<mmsghdr, maxDatagramBatch> messages;
+		std::array<iovec, maxDatagramBatch> iovecs;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			iovecs[i].iov_base = datagrams[i].buf;
+			iovecs[i].iov_len = bufferSize;
+			messages[i] = {};
+			messages[i].msg_hdr.msg_name = &datagrams[i].peer;
+			messages[i].msg_hdr.msg_namelen = sizeof(NetSocketIPv4Address);
+			messages[i].msg_hdr.msg_iov = &iovecs[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+		int result = recvmmsg(_socket, messages.data(), count, 0, nullptr);
+		if (result == NativeSocketError)
+		{
+			int err = LENET_GET_LAST_ERROR();
+			if (IsWouldBlockError(err)) return false;
+			if (IsPeerUnreachableError(err))
+			{
+				LENET_LOG_DEBUG(IO, "Datagram peer unreachable: {}", err);
+				return false;
+			}
+			LENET_ERROR(err, "Can't receive datagrams");
+			return false;
+		}
+		for (int i = 0; i < result; ++i)
+		{
+			datagrams[i].len = messages[i].msg_len;
+			datagrams[i].truncated = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+		}
+		outCount = static_cast<uint32_t>(result);
+#else
+		for (; outCount < count; ++outCount)
+		{
+			NetDatagram& datagram = datagrams[outCount];
+	#ifdef LE_BUILD_PLATFORM_WINDOWS
+			int addressSize = sizeof(NetSocketIPv4Address);
+	#else
+			socklen_t addressSize = sizeof(NetSocketIPv4Address);
+	#endif
+			int received = static_cast<int>(recvfrom(_socket, datagram.buf, bufferSize, 0, reinterpret_cast<sockaddr*>(&datagram.peer), &addressSize));
+			datagram.truncated = false;
+			if (received == NativeSocketError)
+			{
+				int err = LENET_GET_LAST_ERROR();
+	#ifdef LE_BUILD_PLATFORM_WINDOWS
+				if (err == WSAEMSGSIZE)
+				{
+					datagram.len = bufferSize;
+					datagram.truncated = true;
+					continue;
+				}
+	#endif
+				if (IsWouldBlockError(err)) break;
+				if (IsPeerUnreachableError(err))
+				{
+					LENET_LOG_DEBUG(IO, "Datagram peer unreachable: {}", err);
+					break;
+				}
+				LENET_ERROR(err, "Can't receive datagram");
+				break;
+			}
+			datagram.len = static_cast<uint32_t>(received);
+		}
+#endif
+		return outCount != 0;
+	}
+
+	bool NetSocket::SendDatagrams(const NetDatagram* datagrams, uint32_t count, uint32_t& outCount) const
+	{
+		outCount = 0;
+		count = std::min(count, maxDatagramBatch);
+#ifdef LE_BUILD_PLATFORM_LINUX
+		std::array<mmsghdr, maxDatagramBatch> messages;
+		std::array<iovec, maxDatagramBatch> iovecs;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			iovecs[i].iov_base = datagrams[i].buf;
+			iovecs[i].iov_len = datagrams[i].len;
+			messages[i] = {};
+			messages[i].msg_hdr.msg_name = const_cast<NetSocketIPv4Address*>(&datagrams[i].peer);
+			messages[i].msg_hdr.msg_namelen = sizeof(NetSocketIPv4Address);
+			messages[i].msg_hdr.msg_iov = &iovecs[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+		int result = sendmmsg(_socket, messages.data(), count, 0);
+		if (result != NativeSocketError)
+		{
+			outCount = static_cast<uint32_t>(result);
+			return outCount != 0;
+		}
+		int err = LENET_GET_LAST_ERROR();
+#else
+		int err = 0;
+		for (; outCount < count; ++outCount)
+		{
+			const NetDatagram& datagram = datagrams[outCount];
+			if (sendto(_socket, datagram.buf, static_cast<int>(datagram.len), 0, reinterpret_cast<const sockaddr*>(&datagram.peer), sizeof(NetSocketIPv4Address)) ==
+				NativeSocketError)
+			{
+				err = LENET_GET_LAST_ERROR();
+				break;
+			}
+		}
+		if (outCount == count) return true;
+#endif
+		if (IsWouldBlockError(err)) return outCount != 0;
+		// Retrying would fail the same way, the datagram is dropped like the network would drop it
+		LENET_LOG_DEBUG(IO, "Can't send datagram to {}: {}", NetSocketIPv4Address(datagrams[outCount].peer).ToString(), err);
+		++outCount;
+		return true;
+	}
+
+	bool NetSocket::SendSegments(NetSocketIPv4Address peer, const char* buf, uint32_t size, uint16_t segmentSize, int& outBytesTransferred) const
+	{
+		outBytesTransferred = 0;
+#ifdef UDP_SEGMENT
+		iovec iov{ const_cast<char*>(buf), size };
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))]{};
+		msghdr message{};
+		message.msg_name = &peer;
+		message.msg_namelen = sizeof(peer);
+		message.msg_iov = &iov;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		cmsghdr* controlMessage = CMSG_FIRSTHDR(&message);
+		controlMessage->cmsg_level = SOL_UDP;
+		controlMessage->cmsg_type = UDP_SEGMENT;
+		controlMessage->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		std::memcpy(CMSG_DATA(controlMessage), &segmentSize, sizeof(segmentSize));
+
+		outBytesTransferred = static_cast<int>(sendmsg(_socket, &message, 0));
+		if (outBytesTransferred == NativeSocketError)
+		{
+			int err = LENET_GET_LAST_ERROR();
+			if (IsWouldBlockError(err))
+			{
+				outBytesTransferred = -1;
+				return false;
+			}
+			// EIO from devices without checksum offload, EINVAL from kernels without UDP GSO
+			LENET_LOG_DEBUG(IO, "Can't send {}b in {}b segments: {}", size, segmentSize, err);
+			outBytesTransferred = 0;
+			return false;
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
 
 	NativeSocket NetSocket::GetNativeSocket() const
 	{
@@ -178,6 +507,13 @@ namespace LimeEngine::Net
 		_socket = socket;
 	}
 
+	NativeSocket NetSocket::Release() noexcept
+	{
+		NativeSocket socket = _socket;
+		_socket = InvalidNativeSocket;
+		return socket;
+	}
+
 	uint64_t NetSocket::GetId() const
 	{
 		return _socket;
@@ -187,4 +523,4 @@ namespace LimeEngine::Net
 	{
 		return _socket != InvalidNativeSocket;
 	}
-}
\ No newline at end of file
+}
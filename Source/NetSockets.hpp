@@ -7,8 +7,31 @@
 
 namespace LimeEngine::Net
 {
+	enum class NetSocketType
+	{
+		Stream = SOCK_STREAM,
+		Datagram = SOCK_DGRAM
+	};
+
+	// One datagram of a batch, the buffer is owned by the caller
+	struct NetDatagram
+	{
+		NetSocketIPv4Address peer;
+		char* buf = nullptr;
+		uint32_t len = 0;
+		// Received datagram that was larger than the buffer, only its beginning is in buf
+		bool truncated = false;
+	};
+
 	class NetSocket
 	{
+	public:
+		static constexpr size_t maxSendBuffers = 64;
+		// Datagrams moved by one ReceiveDatagrams or SendDatagrams call
+		static constexpr uint32_t maxDatagramBatch = 64;
+		// Kernel limit of segments in one UDP_SEGMENT send
+		static constexpr uint32_t maxSegments = 64;
+
 	public:
 		NetSocket(const NetSocket&) = delete;
 		NetSocket& operator=(const NetSocket&) = delete;
@@ -17,29 +40,53 @@ namespace LimeEngine::Net
 		NetSocket& operator=(NetSocket&& socket) noexcept;
 
 		NetSocket() noexcept = default;
-		explicit NetSocket(SOCKET _socket) noexcept : _socket(_socket) {}
+		explicit NetSocket(NativeSocket _socket) noexcept : _socket(_socket) {}
 		explicit NetSocket(NetAddressType addressType, bool async = false);
+		NetSocket(NetAddressType addressType, NetSocketType socketType, bool async = false);
 
 		~NetSocket();
 
 	public:
 		void SetNonblockingMode(bool isNonblockingMode = true);
 		void SetReuseAddr(bool isReuseAddr = true);
+		// Disables Nagle's algorithm, small writes go out immediately
+		void SetNoDelay(bool isNoDelay = true);
+		// Lets reads and polls of the socket spin on the device queue for up to the given time (Linux SO_BUSY_POLL).
+		// Values above net.core.busy_read need CAP_NET_ADMIN, returns false if the option could not be set.
+		bool SetBusyPoll(uint32_t microseconds);
 
 		void Bind(NetSocketIPv4Address address);
 		void Listen();
 		void Listen(int maxClient) const;
 		bool Accept(NetSocket& outSocket) const;
 		bool Connect(NetSocketIPv4Address address) const;
+		bool WaitForRead(uint32_t timeout) const;
 
 		void Close();
 		void Shutdown();
 
+		// On failure outBytesTransferred is 0 if the connection is closed and -1 if the call would block
 		bool Send(const char* buf, int bufSize, int& outBytesTransferred) const;
+		// Gathers up to maxSendBuffers buffers into one call (sendmsg or WSASend)
+		bool SendBuffers(NetBuffer* netBuffers, uint32_t netBufferCount, int& outBytesTransferred) const;
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		bool SendAsync(NetBuffer* netBuffer, NativeIOContext* nativeIoContext);
+		bool SendBuffersAsync(NetBuffer* netBuffers, uint32_t netBufferCount, NativeIOContext* nativeIoContext);
+#endif
 
 		bool Receive(char* buf, int bufSize, int& outBytesTransferred) const;
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		bool ReceiveAsync(NetBuffer* netBuffer, NativeIOContext* nativeIoContext);
+#endif
+
+		// Datagram sockets. Receives up to count datagrams of at most bufferSize bytes in one call (recvmmsg), false if none is waiting.
+		bool ReceiveDatagrams(NetDatagram* datagrams, uint32_t count, uint32_t bufferSize, uint32_t& outCount) const;
+		// Sends up to count datagrams from the front in one call (sendmmsg). outCount includes a datagram dropped after an error
+		// other than a full send buffer, false if the call would block before anything was sent.
+		bool SendDatagrams(const NetDatagram* datagrams, uint32_t count, uint32_t& outCount) const;
+		// The kernel splits buf into datagrams of segmentSize bytes, the last one may be shorter (Linux UDP_SEGMENT).
+		// On failure outBytesTransferred is -1 if the call would block and 0 if segmentation isn't supported, the caller then sends the segments itself.
+		bool SendSegments(NetSocketIPv4Address peer, const char* buf, uint32_t size, uint16_t segmentSize, int& outBytesTransferred) const;
 
 		template <size_t BufferSize>
 		bool Receive(BufferPool<BufferSize>& bufferPool, std::string& outMsg) const
@@ -69,11 +116,12 @@ namespace LimeEngine::Net
 
 		NativeSocket GetNativeSocket() const;
 		void SetSocket(NativeSocket socket);
+		NativeSocket Release() noexcept;
 
 		uint64_t GetId() const;
 		bool IsValid() const;
 
 	protected:
-		NativeSocket _socket = INVALID_SOCKET;
+		NativeSocket _socket = InvalidNativeSocket;
 	};
 }
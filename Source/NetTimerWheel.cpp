@@ -0,0 +1,214 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetTimerWheel.hpp"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace LimeEngine::Net
+{
+	NetTimerWheel::NetTimerWheel() noexcept : start(Clock::now()) {}
+
+	NetTimerId NetTimerWheel::Schedule(std::chrono::milliseconds delay, std::function<void()> callback)
+	{
+		// One tick is added so that a timer never fires before its delay has passed
+		uint64_t expiry = std::max<uint64_t>(NowTick() + ToTicks(delay) + 1ull, currentTick + 1ull);
+		NetTimerId id = timers.Emplace(expiry, 0ull, std::move(callback));
+		if (id != SlotMap<Timer>::invalidHandle) Link(*timers.Get(id));
+		return id;
+	}
+
+	NetTimerId NetTimerWheel::ScheduleRepeating(std::chrono::milliseconds period, std::function<void()> callback)
+	{
+		uint64_t periodTicks = std::max<uint64_t>(ToTicks(period), 1ull);
+		uint64_t expiry = std::max<uint64_t>(NowTick() + periodTicks + 1ull, currentTick + 1ull);
+		NetTimerId id = timers.Emplace(expiry, periodTicks, std::move(callback));
+		if (id != SlotMap<Timer>::invalidHandle) Link(*timers.Get(id));
+		return id;
+	}
+
+	bool NetTimerWheel::Reschedule(NetTimerId id, std::chrono::milliseconds delay)
+	{
+		Timer* timer = timers.Get(id);
+		if (timer == nullptr || timer->cancelled) return false;
+
+		Unlink(*timer);
+		timer->expiry = std::max<uint64_t>(NowTick() + ToTicks(delay) + 1ull, currentTick + 1ull);
+		Link(*timer);
+		return true;
+	}
+
+	bool NetTimerWheel::Cancel(NetTimerId id)
+	{
+		Timer* timer = timers.Get(id);
+		if (timer == nullptr || timer->cancelled) return false;
+
+		Unlink(*timer);
+		// A running callback is destroyed once it returns
+		if (timer->running) { timer->cancelled = true; }
+		else { timers.Erase(id); }
+		return true;
+	}
+
+	bool NetTimerWheel::Contains(NetTimerId id) const noexcept
+	{
+		const Timer* timer = timers.Get(id);
+		return timer != nullptr && !timer->cancelled;
+	}
+
+	size_t NetTimerWheel::Advance()
+	{
+		uint64_t nowTick = NowTick();
+		size_t fired = 0;
+		while (currentTick < nowTick)
+		{
+			if (timers.Empty())
+			{
+				currentTick = nowTick;
+				break;
+			}
+			// Ticks without level 0 timers are skipped up to the next cascade
+			if (occupied[0] == 0)
+			{
+				uint64_t skipTo = std::min<uint64_t>(currentTick | (slotsPerLevel - 1ull), nowTick);
+				if (skipTo > currentTick)
+				{
+					currentTick = skipTo;
+					continue;
+				}
+			}
+
+			++currentTick;
+			for (uint32_t level = 1; level < levels; ++level)
+			{
+				if ((currentTick & ((1ull << (slotBits * level)) - 1ull)) != 0) break;
+				Cascade(level);
+			}
+			fired += ExpireSlot(static_cast<uint32_t>(currentTick & (slotsPerLevel - 1ull)));
+		}
+		return fired;
+	}
+
+	uint32_t NetTimerWheel::NextTimeout(uint32_t maxTimeout) const noexcept
+	{
+		if (timers.Empty()) return maxTimeout;
+
+		uint64_t nearestTick = std::numeric_limits<uint64_t>::max();
+		for (uint32_t level = 0; level < levels; ++level)
+		{
+			uint64_t slots = occupied[level];
+			if (slots == 0) continue;
+
+			uint32_t shift = slotBits * level;
+			uint64_t position = currentTick >> shift;
+			// Distance from the current slot to the next occupied one, a slot at the current position is a full turn away
+			uint32_t index = static_cast<uint32_t>(position & (slotsPerLevel - 1ull));
+			uint64_t distance = std::countr_zero(std::rotr(slots, static_cast<int>((index + 1u) % slotsPerLevel))) + 1ull;
+			nearestTick = std::min(nearestTick, (position + distance) << shift);
+		}
+
+		uint64_t nowTick = NowTick();
+		if (nearestTick <= nowTick) return 0u;
+		return static_cast<uint32_t>(std::min(nearestTick - nowTick, static_cast<uint64_t>(maxTimeout)));
+	}
+
+	size_t NetTimerWheel::Count() const noexcept
+	{
+		return timers.Size();
+	}
+
+	bool NetTimerWheel::Empty() const noexcept
+	{
+		return timers.Empty();
+	}
+
+	uint64_t NetTimerWheel::ToTicks(std::chrono::milliseconds duration) noexcept
+	{
+		return (duration.count() > 0) ? static_cast<uint64_t>(duration.count()) : 0ull;
+	}
+
+	uint64_t NetTimerWheel::NowTick() const noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+	}
+
+	void NetTimerWheel::Link(Timer& timer)
+	{
+		uint64_t delta = (timer.expiry > currentTick) ? (timer.expiry - currentTick) : 0ull;
+		uint32_t level = 0;
+		while (level + 1u < levels && delta >= (1ull << (slotBits * (level + 1u))))
+		{
+			++level;
+		}
+		// Deadlines beyond the last level are parked there and placed again when they are cascaded
+		uint64_t position = currentTick + std::min(delta, maxDelta);
+
+		timer.level = level;
+		timer.slot = static_cast<uint32_t>((position >> (slotBits * level)) & (slotsPerLevel - 1ull));
+		Slot& slot = wheel[level][timer.slot];
+		timer.prev = nullptr;
+		timer.next = slot.head;
+		if (slot.head != nullptr) slot.head->prev = &timer;
+		slot.head = &timer;
+		occupied[level] |= 1ull << timer.slot;
+		timer.linked = true;
+	}
+
+	void NetTimerWheel::Unlink(Timer& timer) noexcept
+	{
+		if (!timer.linked) return;
+
+		Slot& slot = wheel[timer.level][timer.slot];
+		if (timer.prev != nullptr) { timer.prev->next = timer.next; }
+		else { slot.head = timer.next; }
+		if (timer.next != nullptr) timer.next->prev = timer.prev;
+		if (slot.head == nullptr) occupied[timer.level] &= ~(1ull << timer.slot);
+
+		timer.prev = nullptr;
+		timer.next = nullptr;
+		timer.linked = false;
+	}
+
+	void NetTimerWheel::Cascade(uint32_t level)
+	{
+		uint32_t slotIndex = static_cast<uint32_t>((currentTick >> (slotBits * level)) & (slotsPerLevel - 1ull));
+		Slot& slot = wheel[level][slotIndex];
+		Timer* timer = std::exchange(slot.head, nullptr);
+		occupied[level] &= ~(1ull << slotIndex);
+
+		while (timer != nullptr)
+		{
+			Timer* next = timer->next;
+			timer->linked = false;
+			Link(*timer);
+			timer = next;
+		}
+	}
+
+	size_t NetTimerWheel::ExpireSlot(uint32_t slotIndex)
+	{
+		size_t fired = 0;
+		Slot& slot = wheel[0][slotIndex];
+		// Callbacks may schedule, reschedule and cancel timers, including their own
+		while (Timer* timer = slot.head)
+		{
+			Unlink(*timer);
+			NetTimerId id = timer->id;
+			if (timer->period != 0)
+			{
+				timer->expiry = currentTick + timer->period;
+				Link(*timer);
+			}
+
+			timer->running = true;
+			timer->callback();
+			timer->running = false;
+			++fired;
+
+			// Fired one-shot timers that were not rescheduled are released
+			if (timer->cancelled || !timer->linked) timers.Erase(id);
+		}
+		return fired;
+	}
+}
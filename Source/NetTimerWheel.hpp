@@ -0,0 +1,93 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <functional>
+#include "SlotMap.hpp"
+
+namespace LimeEngine::Net
+{
+	using NetTimerId = uint64_t;
+
+	// Hierarchical timer wheel with 1 ms ticks: 5 levels of 64 slots cover about 12 days, later deadlines are parked in the last level.
+	// Schedule, Reschedule and Cancel are O(1). Timers are kept in a SlotMap, so a cancelled or fired timer's id is safely rejected.
+	// Must be used from one thread, callbacks run inside Advance.
+	class NetTimerWheel
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+	private:
+		static constexpr uint32_t slotBits = 6;
+		static constexpr uint32_t slotsPerLevel = 1u << slotBits;
+		static constexpr uint32_t levels = 5;
+		static constexpr uint64_t maxDelta = (1ull << (slotBits * levels)) - 1ull;
+
+		struct Timer
+		{
+			Timer(NetTimerId id, uint64_t expiry, uint64_t period, std::function<void()>&& callback) :
+				id(id), expiry(expiry), period(period), callback(std::move(callback))
+			{}
+
+			NetTimerId id;
+			uint64_t expiry;
+			// 0 for one-shot timers
+			uint64_t period;
+			std::function<void()> callback;
+
+			Timer* prev = nullptr;
+			Timer* next = nullptr;
+			uint32_t level = 0;
+			uint32_t slot = 0;
+			bool linked = false;
+			bool running = false;
+			bool cancelled = false;
+		};
+
+		struct Slot
+		{
+			Timer* head = nullptr;
+		};
+
+	public:
+		NetTimerWheel(const NetTimerWheel&) = delete;
+		NetTimerWheel& operator=(const NetTimerWheel&) = delete;
+
+		NetTimerWheel() noexcept;
+
+		NetTimerId Schedule(std::chrono::milliseconds delay, std::function<void()> callback);
+		NetTimerId ScheduleRepeating(std::chrono::milliseconds period, std::function<void()> callback);
+		// Moves the deadline of a pending timer, returns false for unknown ids
+		bool Reschedule(NetTimerId id, std::chrono::milliseconds delay);
+		bool Cancel(NetTimerId id);
+		bool Contains(NetTimerId id) const noexcept;
+
+		// Runs the callbacks of every expired timer, returns their number
+		size_t Advance();
+		// Milliseconds until the nearest deadline, at most maxTimeout. Deadlines in the higher levels are rounded down
+		// to the tick they are cascaded at, so the result is never later than the actual deadline.
+		uint32_t NextTimeout(uint32_t maxTimeout) const noexcept;
+
+		size_t Count() const noexcept;
+		bool Empty() const noexcept;
+
+	private:
+		static uint64_t ToTicks(std::chrono::milliseconds duration) noexcept;
+		uint64_t NowTick() const noexcept;
+
+		void Link(Timer& timer);
+		void Unlink(Timer& timer) noexcept;
+		void Cascade(uint32_t level);
+		size_t ExpireSlot(uint32_t slot);
+
+	private:
+		SlotMap<Timer> timers;
+		std::array<std::array<Slot, slotsPerLevel>, levels> wheel{};
+		// Bit per non-empty slot, the nearest deadline is found without scanning slots
+		std::array<uint64_t, levels> occupied{};
+		Clock::time_point start;
+		uint64_t currentTick = 0;
+	};
+}
@@ -0,0 +1,120 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include "NetMetrics.hpp"
+
+namespace LimeEngine::Net
+{
+	enum class NetWaitMode : uint8_t
+	{
+		// Every wait blocks for up to its timeout, no CPU is used while idle
+		Block,
+		// Polls without blocking for up to spinTime, then blocks
+		SpinThenBlock,
+		// Never blocks, the event loop keeps a core busy
+		BusyPoll,
+		// Spins while events recently arrived within spinTime of each other and blocks otherwise
+		Adaptive
+	};
+
+	struct NetWaitOptions
+	{
+		NetWaitMode mode = NetWaitMode::Block;
+		// Spin budget of SpinThenBlock and upper bound of the spin of Adaptive
+		std::chrono::microseconds spinTime{ 50 };
+		// SO_BUSY_POLL of every new connection, so the kernel also spins on the device queue. Zero leaves the socket default.
+		uint32_t socketBusyPoll = 0;
+	};
+
+	inline uint64_t NanosecondsSince(std::chrono::steady_clock::time_point start) noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	// Times one wait of an event manager as blocked time, polls with a zero timeout are accounted by NetWaitStrategy
+	template <typename TWait>
+	auto TimedWait(uint32_t timeout, TWait&& wait)
+	{
+		if (timeout == 0) return wait();
+		auto start = std::chrono::steady_clock::now();
+		auto result = wait();
+		NetMetrics::Add(NetCounter::BlockedNanoseconds, NanosecondsSince(start));
+		return result;
+	}
+
+	// Decides how long each wait of an event loop blocks.
+	// Polls that found nothing count as spinning, the time in blocking waits is reported by the event managers (see TimedWait).
+	class NetWaitStrategy
+	{
+	public:
+		NetWaitStrategy() noexcept = default;
+		explicit NetWaitStrategy(const NetWaitOptions& options) noexcept : options(options) {}
+
+		// handleEvents(timeout) waits once, handles the events and returns whether there were any
+		template <typename THandleEvents>
+		bool Wait(uint32_t timeout, THandleEvents&& handleEvents)
+		{
+			switch (options.mode)
+			{
+				case NetWaitMode::SpinThenBlock: return SpinThenBlock(timeout, options.spinTime, handleEvents);
+				case NetWaitMode::BusyPoll: return Poll(handleEvents);
+				case NetWaitMode::Adaptive: return WaitAdaptive(timeout, handleEvents);
+				default: return handleEvents(timeout);
+			}
+		}
+
+		const NetWaitOptions& GetOptions() const noexcept
+		{
+			return options;
+		}
+
+	private:
+		// The whole round of the event loop counts, not just the wait
+		template <typename THandleEvents>
+		static bool Poll(THandleEvents& handleEvents)
+		{
+			auto start = std::chrono::steady_clock::now();
+			if (handleEvents(0u)) return true;
+			NetMetrics::Add(NetCounter::SpinNanoseconds, NanosecondsSince(start));
+			return false;
+		}
+
+		template <typename THandleEvents>
+		static bool SpinThenBlock(uint32_t timeout, std::chrono::nanoseconds spinTime, THandleEvents& handleEvents)
+		{
+			if (spinTime.count() > 0)
+			{
+				auto deadline = std::chrono::steady_clock::now() + spinTime;
+				do
+				{
+					if (Poll(handleEvents)) return true;
+				} while (std::chrono::steady_clock::now() < deadline);
+			}
+			return timeout != 0 && handleEvents(timeout);
+		}
+
+		// The time until events arrived is smoothed over recent waits (weight 1/8, as TCP smooths round-trip times).
+		// While it stays below spinTime the loop spins for twice that long, otherwise it blocks right away.
+		template <typename THandleEvents>
+		bool WaitAdaptive(uint32_t timeout, THandleEvents& handleEvents)
+		{
+			std::chrono::nanoseconds spinTime = options.spinTime;
+			std::chrono::nanoseconds spin = (smoothedGap < spinTime) ? std::min(spinTime, 2 * smoothedGap) : std::chrono::nanoseconds::zero();
+
+			auto start = std::chrono::steady_clock::now();
+			bool hasEvents = SpinThenBlock(timeout, spin, handleEvents);
+			// A wait that timed out only says the gap is at least the timeout
+			std::chrono::nanoseconds gap = std::chrono::steady_clock::now() - start;
+			smoothedGap += (gap - smoothedGap) / 8;
+			return hasEvents;
+		}
+
+	private:
+		NetWaitOptions options;
+		std::chrono::nanoseconds smoothedGap{ 0 };
+	};
+}
@@ -0,0 +1,93 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetWakeup.hpp"
+#include <utility>
+
+#ifdef LE_BUILD_PLATFORM_LINUX
+	#include <sys/eventfd.h>
+#endif
+
+namespace LimeEngine::Net
+{
+	NetWakeup::NetWakeup()
+	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (handle == InvalidNativeSocket)
+		{
+			LENET_LAST_ERROR_MSG("Can't create wakeup socket");
+			return;
+		}
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		int addressSize = sizeof(address);
+		unsigned long nonblocking = 1;
+		if (bind(handle, reinterpret_cast<sockaddr*>(&address), addressSize) == NativeSocketError ||
+			getsockname(handle, reinterpret_cast<sockaddr*>(&address), &addressSize) == NativeSocketError ||
+			connect(handle, reinterpret_cast<sockaddr*>(&address), addressSize) == NativeSocketError || ioctlsocket(handle, FIONBIO, &nonblocking) == NativeSocketError)
+		{
+			LENET_LAST_ERROR_MSG("Can't set up wakeup socket");
+		}
+#else
+		handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (handle == InvalidNativeSocket) { LENET_LAST_ERROR_MSG("Can't create wakeup eventfd"); }
+#endif
+	}
+
+	NetWakeup::~NetWakeup()
+	{
+		Close();
+	}
+
+	NetWakeup::NetWakeup(NetWakeup&& other) noexcept :
+		handle(std::exchange(other.handle, InvalidNativeSocket)), signaled(other.signaled.load(std::memory_order_relaxed))
+	{}
+	NetWakeup& NetWakeup::operator=(NetWakeup&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			handle = std::exchange(other.handle, InvalidNativeSocket);
+			signaled.store(other.signaled.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		return *this;
+	}
+
+	void NetWakeup::Signal()
+	{
+		if (signaled.exchange(true, std::memory_order_acq_rel)) return;
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		char value = 0;
+		send(handle, &value, sizeof(value), 0);
+#else
+		uint64_t value = 1;
+		[[maybe_unused]] ssize_t result = write(handle, &value, sizeof(value));
+#endif
+	}
+
+	void NetWakeup::Drain()
+	{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		char value;
+		while (recv(handle, &value, sizeof(value), 0) > 0) {}
+#else
+		uint64_t value;
+		[[maybe_unused]] ssize_t result = read(handle, &value, sizeof(value));
+#endif
+		// A read-modify-write, so it synchronizes with the exchange of a Signal that found the flag still set
+		signaled.exchange(false, std::memory_order_acq_rel);
+	}
+
+	void NetWakeup::Close()
+	{
+		if (handle == InvalidNativeSocket) return;
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		closesocket(handle);
+#else
+		close(handle);
+#endif
+		handle = InvalidNativeSocket;
+	}
+}
@@ -0,0 +1,41 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <atomic>
+#include "NetBase.hpp"
+
+namespace LimeEngine::Net
+{
+	// Interrupts a blocking wait of an event loop from any thread. The loop polls the handle for reading next to its sockets.
+	// An eventfd on Linux, a loopback UDP socket that sends to itself on Windows.
+	class NetWakeup
+	{
+	public:
+		NetWakeup();
+		~NetWakeup();
+
+		NetWakeup(const NetWakeup&) = delete;
+		NetWakeup& operator=(const NetWakeup&) = delete;
+		NetWakeup(NetWakeup&& other) noexcept;
+		NetWakeup& operator=(NetWakeup&& other) noexcept;
+
+		NativeSocket GetNativeHandle() const noexcept
+		{
+			return handle;
+		}
+
+		// Any thread. Only the first signal after a Drain reaches the kernel.
+		void Signal();
+		// Event loop thread, once the handle was reported readable.
+		// Work posted before a signal must be picked up after the Drain, since the next signal is coalesced with it otherwise.
+		void Drain();
+
+	private:
+		void Close();
+
+	private:
+		NativeSocket handle = InvalidNativeSocket;
+		std::atomic<bool> signaled = false;
+	};
+}
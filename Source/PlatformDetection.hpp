@@ -29,7 +29,6 @@
 	#error "Android is not supported!"
 #elif defined(__linux__)
 	#define LE_BUILD_PLATFORM_LINUX
-	#error "Linux is not supported!"
 #else
 	#error "Unknown platform!"
 #endif
\ No newline at end of file
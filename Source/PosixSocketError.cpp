@@ -0,0 +1,67 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "PosixSocketError.hpp"
+#include "PlatformDetection.hpp"
+
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+	#include <cerrno>
+
+	#define MACRO_TO_STR_CASE(macro) \
+		case macro: return #macro;
+
+std::string GetPosixSocketErrorCodeName(int err)
+{
+	switch (err)
+	{
+		MACRO_TO_STR_CASE(EPERM)
+		MACRO_TO_STR_CASE(ENOENT)
+		MACRO_TO_STR_CASE(EINTR)
+		MACRO_TO_STR_CASE(EIO)
+		MACRO_TO_STR_CASE(EBADF)
+		MACRO_TO_STR_CASE(EAGAIN)
+		MACRO_TO_STR_CASE(ENOMEM)
+		MACRO_TO_STR_CASE(EACCES)
+		MACRO_TO_STR_CASE(EFAULT)
+		MACRO_TO_STR_CASE(EBUSY)
+		MACRO_TO_STR_CASE(EEXIST)
+		MACRO_TO_STR_CASE(EINVAL)
+		MACRO_TO_STR_CASE(ENFILE)
+		MACRO_TO_STR_CASE(EMFILE)
+		MACRO_TO_STR_CASE(ENOSPC)
+		MACRO_TO_STR_CASE(EPIPE)
+		MACRO_TO_STR_CASE(ENOSYS)
+		MACRO_TO_STR_CASE(ENOTSOCK)
+		MACRO_TO_STR_CASE(EDESTADDRREQ)
+		MACRO_TO_STR_CASE(EMSGSIZE)
+		MACRO_TO_STR_CASE(EPROTOTYPE)
+		MACRO_TO_STR_CASE(ENOPROTOOPT)
+		MACRO_TO_STR_CASE(EPROTONOSUPPORT)
+		MACRO_TO_STR_CASE(ESOCKTNOSUPPORT)
+		MACRO_TO_STR_CASE(EOPNOTSUPP)
+		MACRO_TO_STR_CASE(EPFNOSUPPORT)
+		MACRO_TO_STR_CASE(EAFNOSUPPORT)
+		MACRO_TO_STR_CASE(EADDRINUSE)
+		MACRO_TO_STR_CASE(EADDRNOTAVAIL)
+		MACRO_TO_STR_CASE(ENETDOWN)
+		MACRO_TO_STR_CASE(ENETUNREACH)
+		MACRO_TO_STR_CASE(ENETRESET)
+		MACRO_TO_STR_CASE(ECONNABORTED)
+		MACRO_TO_STR_CASE(ECONNRESET)
+		MACRO_TO_STR_CASE(ENOBUFS)
+		MACRO_TO_STR_CASE(EISCONN)
+		MACRO_TO_STR_CASE(ENOTCONN)
+		MACRO_TO_STR_CASE(ESHUTDOWN)
+		MACRO_TO_STR_CASE(ETOOMANYREFS)
+		MACRO_TO_STR_CASE(ETIMEDOUT)
+		MACRO_TO_STR_CASE(ECONNREFUSED)
+		MACRO_TO_STR_CASE(EHOSTDOWN)
+		MACRO_TO_STR_CASE(EHOSTUNREACH)
+		MACRO_TO_STR_CASE(EALREADY)
+		MACRO_TO_STR_CASE(EINPROGRESS)
+		MACRO_TO_STR_CASE(ECANCELED)
+		MACRO_TO_STR_CASE(ETIME)
+		default: return "Unknown error code";
+	}
+}
+#endif
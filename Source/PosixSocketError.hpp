@@ -0,0 +1,7 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <string>
+
+std::string GetPosixSocketErrorCodeName(int err);
@@ -0,0 +1,81 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetProtocolFramedTCP.hpp"
+#include "../NetContext.hpp"
+
+namespace LimeEngine::Net
+{
+	std::string NetProtocolFramedTCP::Frame(std::string_view message)
+	{
+		std::string frame(headerSize + message.size(), '\0');
+		EncodeHeader(frame.data(), static_cast<uint32_t>(message.size()));
+		memcpy(frame.data() + headerSize, message.data(), message.size());
+		return frame;
+	}
+
+	bool NetProtocolFramedTCP::Send(NetSocket& socket, const char* buf, int bufSize, int& outBytesTransferred)
+	{
+		if (socket.Send(buf, bufSize, outBytesTransferred))
+		{
+			LENET_LOG_TRACE(IO, "Send {}b{}", outBytesTransferred, ((outBytesTransferred != bufSize) ? " part" : ""));
+			return true;
+		}
+		return false;
+	}
+
+	bool NetProtocolFramedTCP::SendBuffers(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, int& outBytesTransferred)
+	{
+		if (netBufferCount == 1) return Send(socket, netBuffers->buf, static_cast<int>(netBuffers->len), outBytesTransferred);
+		if (socket.SendBuffers(netBuffers, netBufferCount, outBytesTransferred))
+		{
+			LENET_LOG_TRACE(IO, "Send {}b in {} buffers", outBytesTransferred, netBufferCount);
+			return true;
+		}
+		return false;
+	}
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	bool NetProtocolFramedTCP::SendAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext)
+	{
+		if (socket.SendAsync(netBuffer, nativeIoContext))
+		{
+			LENET_LOG_TRACE(IO, "Async Send started");
+			return true;
+		}
+		return false;
+	}
+
+	bool NetProtocolFramedTCP::SendBuffersAsync(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, NativeIOContext* nativeIoContext)
+	{
+		if (socket.SendBuffersAsync(netBuffers, netBufferCount, nativeIoContext))
+		{
+			LENET_LOG_TRACE(IO, "Async Send of {} buffers started", netBufferCount);
+			return true;
+		}
+		return false;
+	}
+#endif
+
+	bool NetProtocolFramedTCP::Receive(NetSocket& socket, char* buf, int bufSize, int& outBytesTransferred)
+	{
+		if (socket.Receive(buf, bufSize, outBytesTransferred))
+		{
+			LENET_LOG_TRACE(IO, "Receive {}b", outBytesTransferred);
+			return true;
+		}
+		return false;
+	}
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	bool NetProtocolFramedTCP::ReceiveAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext)
+	{
+		if (socket.ReceiveAsync(netBuffer, nativeIoContext))
+		{
+			LENET_LOG_TRACE(IO, "Async Receive started");
+			return true;
+		}
+		return false;
+	}
+#endif
+}
@@ -0,0 +1,121 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include "../NetBase.hpp"
+
+namespace LimeEngine::Net
+{
+	class NetSocket;
+
+	// TCP stream of frames: 4-byte little-endian payload length followed by the payload, which may contain any bytes
+	class NetProtocolFramedTCP
+	{
+	public:
+		static constexpr size_t headerSize = sizeof(uint32_t);
+		// Default limit of a received payload, the length comes from the peer
+		static constexpr uint32_t defaultMaxMessageSize = 16u * 1024u * 1024u;
+		// Most memory reserved for a payload before its bytes arrive, larger payloads grow as they are received
+		static constexpr size_t maxReserveSize = 64u * 1024u;
+
+		static void EncodeHeader(char* outHeader, uint32_t messageSize) noexcept
+		{
+			for (size_t i = 0; i < headerSize; ++i)
+			{
+				outHeader[i] = static_cast<char>((messageSize >> (i * 8u)) & 0xFFu);
+			}
+		}
+		static uint32_t DecodeHeader(const char* header) noexcept
+		{
+			uint32_t messageSize = 0;
+			for (size_t i = 0; i < headerSize; ++i)
+			{
+				messageSize |= static_cast<uint32_t>(static_cast<unsigned char>(header[i])) << (i * 8u);
+			}
+			return messageSize;
+		}
+
+		// Returns the header followed by the payload
+		static std::string Frame(std::string_view message);
+
+		static bool Send(NetSocket& socket, const char* buf, int bufSize, int& outBytesTransferred);
+		static bool SendBuffers(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, int& outBytesTransferred);
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		static bool SendAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext);
+		static bool SendBuffersAsync(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, NativeIOContext* nativeIoContext);
+#endif
+
+		static bool Receive(NetSocket& socket, char* buf, int bufSize, int& outBytesTransferred);
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+		static bool ReceiveAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext);
+#endif
+	};
+
+	// Reassembles frames from arbitrary stream chunks. The payload size is known from the header,
+	// so each message is allocated once and payload bytes are copied without being scanned.
+	class NetFrameDecoder
+	{
+	public:
+		// Calls onMessage(std::string&&) for every completed frame, returns false on a malformed stream or a payload over maxMessageSize
+		template <typename TOnMessage>
+		bool Feed(const char* data, size_t size, TOnMessage&& onMessage, uint32_t maxMessageSize = NetProtocolFramedTCP::defaultMaxMessageSize)
+		{
+			if (failed) return false;
+			while (true)
+			{
+				if (headerBytes < NetProtocolFramedTCP::headerSize)
+				{
+					if (size == 0) return true;
+
+					size_t headerPart = std::min(NetProtocolFramedTCP::headerSize - headerBytes, size);
+					memcpy(header.data() + headerBytes, data, headerPart);
+					headerBytes += headerPart;
+					data += headerPart;
+					size -= headerPart;
+					if (headerBytes < NetProtocolFramedTCP::headerSize) return true;
+
+					remaining = NetProtocolFramedTCP::DecodeHeader(header.data());
+					if (remaining > maxMessageSize)
+					{
+						LENET_LOG_ERROR(IO, "[Frame] Message size {} exceeds the limit", remaining);
+						failed = true;
+						return false;
+					}
+					message.reserve(std::min(remaining, NetProtocolFramedTCP::maxReserveSize));
+				}
+
+				size_t payloadPart = std::min(remaining, size);
+				message.append(data, payloadPart);
+				remaining -= payloadPart;
+				data += payloadPart;
+				size -= payloadPart;
+				if (remaining != 0) return true;
+
+				onMessage(std::move(message));
+				message = std::string();
+				headerBytes = 0;
+			}
+		}
+
+		void Reset()
+		{
+			message = std::string();
+			headerBytes = 0;
+			remaining = 0;
+			failed = false;
+		}
+
+	private:
+		std::string message;
+		std::array<char, NetProtocolFramedTCP::headerSize> header{};
+		size_t headerBytes = 0;
+		size_t remaining = 0;
+		// The stream can't be resynchronized after a malformed header
+		bool failed = false;
+	};
+}
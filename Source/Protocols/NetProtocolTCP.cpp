@@ -10,39 +10,64 @@ namespace LimeEngine::Net
 	{
 		if (socket.Send(buf, bufSize, outBytesTransferred))
 		{
-			NetLogger::LogCore("Send {}b{}: {}", outBytesTransferred, ((outBytesTransferred != (bufSize + 1ull)) ? " part" : ""), buf);
+			LENET_LOG_TRACE(IO, "Send {}b{}: {}", outBytesTransferred, ((outBytesTransferred != (bufSize + 1ull)) ? " part" : ""), buf);
 			return true;
 		}
 		return false;
 	}
 
+	bool NetProtocolTCP::SendBuffers(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, int& outBytesTransferred)
+	{
+		if (netBufferCount == 1) return Send(socket, netBuffers->buf, static_cast<int>(netBuffers->len), outBytesTransferred);
+		if (socket.SendBuffers(netBuffers, netBufferCount, outBytesTransferred))
+		{
+			LENET_LOG_TRACE(IO, "Send {}b in {} buffers", outBytesTransferred, netBufferCount);
+			return true;
+		}
+		return false;
+	}
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	bool NetProtocolTCP::SendAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext)
 	{
 		if (socket.SendAsync(netBuffer, nativeIoContext))
 		{
-			NetLogger::LogCore("Async Send started");
+			LENET_LOG_TRACE(IO, "Async Send started");
+			return true;
+		}
+		return false;
+	}
+
+	bool NetProtocolTCP::SendBuffersAsync(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, NativeIOContext* nativeIoContext)
+	{
+		if (socket.SendBuffersAsync(netBuffers, netBufferCount, nativeIoContext))
+		{
+			LENET_LOG_TRACE(IO, "Async Send of {} buffers started", netBufferCount);
 			return true;
 		}
 		return false;
 	}
+#endif
 
 	bool NetProtocolTCP::Receive(NetSocket& socket, char* buf, int bufSize, int& outBytesTransferred)
 	{
 		if (socket.Receive(buf, bufSize, outBytesTransferred))
 		{
-			NetLogger::LogCore("Receive {}b: {}", outBytesTransferred, buf);
+			LENET_LOG_TRACE(IO, "Receive {}b: {}", outBytesTransferred, buf);
 			return true;
 		}
 		return false;
 	}
 
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	bool NetProtocolTCP::ReceiveAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext)
 	{
 		if (socket.ReceiveAsync(netBuffer, nativeIoContext))
 		{
-			NetLogger::LogCore("Async Receive started");
+			LENET_LOG_TRACE(IO, "Async Receive started");
 			return true;
 		}
 		return false;
 	}
+#endif
 }
@@ -13,9 +13,15 @@ namespace LimeEngine::Net
 	{
 	public:
 		static bool Send(NetSocket& socket, const char* buf, int bufSize, int& outBytesTransferred);
+		static bool SendBuffers(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, int& outBytesTransferred);
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		static bool SendAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext);
+		static bool SendBuffersAsync(NetSocket& socket, NetBuffer* netBuffers, uint32_t netBufferCount, NativeIOContext* nativeIoContext);
+#endif
 
 		static bool Receive(NetSocket& socket, char* buf, int bufSize, int& outBytesTransferred);
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 		static bool ReceiveAsync(NetSocket& socket, NetBuffer* netBuffer, NativeIOContext* nativeIoContext);
+#endif
 	};
 }
@@ -0,0 +1,38 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "NetProtocolUDP.hpp"
+#include "../NetSockets.hpp"
+
+namespace LimeEngine::Net
+{
+	bool NetProtocolUDP::ReceiveBatch(NetSocket& socket, NetDatagram* datagrams, uint32_t count, uint32_t bufferSize, uint32_t& outCount)
+	{
+		if (socket.ReceiveDatagrams(datagrams, count, bufferSize, outCount))
+		{
+			LENET_LOG_TRACE(IO, "Receive {} datagrams", outCount);
+			return true;
+		}
+		return false;
+	}
+
+	bool NetProtocolUDP::SendBatch(NetSocket& socket, const NetDatagram* datagrams, uint32_t count, uint32_t& outCount)
+	{
+		if (socket.SendDatagrams(datagrams, count, outCount))
+		{
+			LENET_LOG_TRACE(IO, "Send {} of {} datagrams", outCount, count);
+			return true;
+		}
+		return false;
+	}
+
+	bool NetProtocolUDP::SendSegments(NetSocket& socket, const NetSocketIPv4Address& peer, const char* buf, uint32_t size, uint16_t segmentSize, int& outBytesTransferred)
+	{
+		if (socket.SendSegments(peer, buf, size, segmentSize, outBytesTransferred))
+		{
+			LENET_LOG_TRACE(IO, "Send {}b in {}b segments", outBytesTransferred, segmentSize);
+			return true;
+		}
+		return false;
+	}
+}
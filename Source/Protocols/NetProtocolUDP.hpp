@@ -0,0 +1,21 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include "../NetBase.hpp"
+
+namespace LimeEngine::Net
+{
+	class NetSocket;
+	class NetSocketIPv4Address;
+	struct NetDatagram;
+
+	// Datagrams in batches, one syscall moves up to NetSocket::maxDatagramBatch of them
+	class NetProtocolUDP
+	{
+	public:
+		static bool ReceiveBatch(NetSocket& socket, NetDatagram* datagrams, uint32_t count, uint32_t bufferSize, uint32_t& outCount);
+		static bool SendBatch(NetSocket& socket, const NetDatagram* datagrams, uint32_t count, uint32_t& outCount);
+		static bool SendSegments(NetSocket& socket, const NetSocketIPv4Address& peer, const char* buf, uint32_t size, uint16_t segmentSize, int& outBytesTransferred);
+	};
+}
@@ -0,0 +1,61 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include "NetBase.hpp"
+
+namespace LimeEngine::Net
+{
+	// Bounded lock-free queue for exactly one producer thread and one consumer thread
+	template <typename T, size_t Capacity>
+	class SPSCQueue
+	{
+		static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	public:
+		SPSCQueue() = default;
+		SPSCQueue(const SPSCQueue&) = delete;
+		SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+		bool Push(T value)
+		{
+			size_t currentTail = tail.load(std::memory_order_relaxed);
+			if (currentTail - cachedHead == Capacity)
+			{
+				cachedHead = head.load(std::memory_order_acquire);
+				if (currentTail - cachedHead == Capacity) return false;
+			}
+			items[currentTail & (Capacity - 1)] = std::move(value);
+			tail.store(currentTail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Pop(T& outValue)
+		{
+			size_t currentHead = head.load(std::memory_order_relaxed);
+			if (currentHead == cachedTail)
+			{
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (currentHead == cachedTail) return false;
+			}
+			outValue = std::move(items[currentHead & (Capacity - 1)]);
+			head.store(currentHead + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Empty() const
+		{
+			return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+		}
+
+	private:
+		alignas(CacheLineSize) std::atomic<size_t> head = 0;
+		size_t cachedTail = 0;
+		alignas(CacheLineSize) std::atomic<size_t> tail = 0;
+		size_t cachedHead = 0;
+		alignas(CacheLineSize) std::array<T, Capacity> items{};
+	};
+}
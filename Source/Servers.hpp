@@ -6,32 +6,26 @@
 #include "NetSockets.hpp"
 #include "NetPollEventManager.hpp"
 #include "NetSelectEventManager.hpp"
+#include "NetEpollEventManager.hpp"
 #include "NetIOCPEventManager.hpp"
+#include "NetIoUringEventManager.hpp"
 #include "Protocols/NetProtocolTCP.hpp"
+#include "Protocols/NetProtocolFramedTCP.hpp"
+#include "NetFramedEventHandler.hpp"
+#include "NetRingEventHandler.hpp"
 #include "NetServer.hpp"
+#include "NetDatagramEndpoint.hpp"
+#include "NetMetricsAdmin.hpp"
 
 namespace LimeEngine::Net::EchoServer
 {
-	template <size_t time>
-	void TimedTask(std::function<void()> task)
-	{
-		static auto start = std::chrono::system_clock::now();
-		auto end = std::chrono::system_clock::now();
-		std::chrono::duration<double> elapsed_seconds = end - start;
-		if (elapsed_seconds.count() > time)
-		{
-			task();
-			start = std::chrono::system_clock::now();
-		}
-	}
-
 	bool LogReceive(NetSocket& socket)
 	{
 		std::array<char, 256> buf;
 		int bytesReceived;
 		if (socket.Receive(buf.data(), buf.size(), bytesReceived))
 		{
-			NetLogger::LogUser("[soc: {}][recv {}b] {}", socket.GetId(), bytesReceived, buf.data());
+			LENET_LOG_INFO(User, "[soc: {}][recv {}b] {}", socket.GetId(), bytesReceived, buf.data());
 			return true;
 		}
 		return false;
@@ -42,7 +36,7 @@ namespace LimeEngine::Net::EchoServer
 		int bytesSent;
 		if (socket.Send(msg.c_str(), msg.size() + 1, bytesSent))
 		{
-			NetLogger::LogUser("[soc: {}][send {}b] {}", socket.GetId(), bytesSent, msg);
+			LENET_LOG_INFO(User, "[soc: {}][send {}b] {}", socket.GetId(), bytesSent, msg);
 			return true;
 		}
 		return false;
@@ -95,6 +89,13 @@ namespace LimeEngine::Net::EchoServer
 			client.SetNonblockingMode();
 		}
 
+		// Every client sends once a second on its own timer
+		NetTimerWheel timers;
+		for (auto& client : clients)
+		{
+			timers.ScheduleRepeating(std::chrono::seconds(1), [&client]() { LogSend(client, largeMessage); });
+		}
+
 		BufferPool<256> bufferPool;
 		std::string msg;
 		bool close = false;
@@ -102,122 +103,309 @@ namespace LimeEngine::Net::EchoServer
 		{
 			for (auto& client : clients)
 			{
-				if (client.Receive(bufferPool, msg)) { NetLogger::LogUser("[soc: {}][recv {}b] {}", client.GetId(), msg.size(), msg); }
+				if (client.Receive(bufferPool, msg)) { LENET_LOG_INFO(User, "[soc: {}][recv {}b] {}", client.GetId(), msg.size(), msg); }
+			}
+			timers.Advance();
+		}
+	}
 
-				TimedTask<1>([&client]() { LogSend(client, largeMessage); });
+	// Talks NetProtocolFramedTCP, the payload is sent as is including the NUL padding of message1KiB
+	void FramedClient(int count = 1)
+	{
+		std::vector<NetSocket> clients;
+		std::vector<NetFrameDecoder> decoders(count);
+		for (int i = 0; i < count; ++i)
+		{
+			auto& client = clients.emplace_back(NetAddressType::IPv4);
+			client.Connect(NetSocketIPv4Address(NetIPv4Address("127.0.0.1"), 3000));
+			client.SetNonblockingMode();
+		}
+
+		const std::string frame = NetProtocolFramedTCP::Frame(std::string_view(message1KiB, sizeof(message1KiB)));
+		NetTimerWheel timers;
+		for (auto& client : clients)
+		{
+			timers.ScheduleRepeating(std::chrono::seconds(1), [&client, &frame]() {
+				int bytesSent;
+				if (client.Send(frame.data(), static_cast<int>(frame.size()), bytesSent)) { LENET_LOG_INFO(User, "[soc: {}][send {}b]", client.GetId(), bytesSent); }
+			});
+		}
+
+		std::array<char, 256> buf;
+		bool close = false;
+		while (!close)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				auto& client = clients[i];
+				int bytesReceived;
+				if (client.Receive(buf.data(), static_cast<int>(buf.size()), bytesReceived))
+				{
+					decoders[i].Feed(buf.data(), bytesReceived, [&client](std::string&& msg) {
+						LENET_LOG_INFO(User, "[soc: {}][recv {}b] {}", client.GetId(), msg.size(), msg.c_str());
+					});
+				}
 			}
+			timers.Advance();
 		}
 	}
 
 	void PollServer()
 	{
-		NetLogger::LogUser("Poll Server");
+		LENET_LOG_INFO(User, "Poll Server");
 
 		NetServer<NetPollEventManager<NetProtocolTCP>> server(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), 3000));
 		server.OnConnection([](NetConnection& connection) {
-			NetLogger::LogUser("Connect: {}", connection.GetId());
+			LENET_LOG_INFO(User, "Connect: {}", connection.GetId());
 
-			connection.OnDisconnect([](const NetConnection& connection) { NetLogger::LogUser("Disconnected: {}", connection.GetId()); });
+			connection.OnDisconnect([](const NetConnection& connection) { LENET_LOG_INFO(User, "Disconnected: {}", connection.GetId()); });
 
 			connection.OnMessage([](const NetConnection& connection, const NetReceivedMessage& receivedMessage) {
-				NetLogger::LogUser("From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
+				LENET_LOG_INFO(User, "From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
 			});
 		});
 
 		server.AddEventHandler();
 
+		// Handlers run as soon as HandleNetEvents has received the messages, no Update() needed
+		server.SetDispatchMode(NetDispatchMode::Inline);
+
+		auto& timers = server.GetTimers();
+		timers.ScheduleRepeating(std::chrono::seconds(3), [&server]() {
+			if (!server.HasConnections()) return;
+			int rndClient = rand() % (server.NumberOfConnections());
+			if (NetConnection* connection = server.GetConnection(rndClient)) connection->Send("Hello from server");
+		});
+
 		bool close = false;
 		while (!close)
 		{
 			server.Accept();
 			server.HandleNetEvents();
-			TimedTask<5>([&server]() {
-				NetLogger::LogUser("Update()");
-				server.Update();
-			});
-			TimedTask<3>([&server]() {
-				if (!server.HasConnections()) return;
-				int rndClient = rand() % (server.NumberOfConnections());
-				auto connection = server.GetConnections().begin();
-				std::advance(connection, rndClient);
-				connection->messagesToSend.emplace("Hello from server");
-			});
 		}
 		server.DisconnectAll();
 	}
 
 	void SelectServer()
 	{
-		NetLogger::LogUser("Select Server");
+		LENET_LOG_INFO(User, "Select Server");
 
 		NetServer<NetSelectEventManager<NetProtocolTCP>> server(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), 3000));
 		server.OnConnection([](NetConnection& connection) {
-			NetLogger::LogUser("Connect: {}", connection.GetId());
+			LENET_LOG_INFO(User, "Connect: {}", connection.GetId());
 
-			connection.OnDisconnect([](const NetConnection& connection) { NetLogger::LogUser("Disconnected: {}", connection.GetId()); });
+			connection.OnDisconnect([](const NetConnection& connection) { LENET_LOG_INFO(User, "Disconnected: {}", connection.GetId()); });
 
 			connection.OnMessage([](const NetConnection& connection, const NetReceivedMessage& receivedMessage) {
-				NetLogger::LogUser("From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
+				LENET_LOG_INFO(User, "From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
 			});
 		});
 
 		server.AddEventHandler();
 
+		// Handlers run as soon as HandleNetEvents has received the messages, no Update() needed
+		server.SetDispatchMode(NetDispatchMode::Inline);
+
+		auto& timers = server.GetTimers();
+		timers.ScheduleRepeating(std::chrono::seconds(3), [&server]() {
+			if (!server.HasConnections()) return;
+			int rndClient = rand() % (server.NumberOfConnections());
+			if (NetConnection* connection = server.GetConnection(rndClient)) connection->Send("Hello from server");
+		});
+
 		bool close = false;
 		while (!close)
 		{
 			server.Accept();
 			server.HandleNetEvents();
-			TimedTask<5>([&server]() {
-				NetLogger::LogUser("Update()");
-				server.Update();
+		}
+		server.DisconnectAll();
+	}
+
+	// Statically dispatched, the calls are inlined into the worker loops instead of going through per-connection std::function objects.
+	// Runs on the event manager thread that owns the connection, so replying from here is safe.
+	class EchoHandler
+	{
+	public:
+		void OnConnection(NetConnection& connection)
+		{
+			LENET_LOG_INFO(User, "Connect: {}", connection.GetId());
+			connection.SetIdleTimeout(std::chrono::seconds(60));
+			// A peer that sends without reading the echo would otherwise grow the send queue without bound
+			connection.SetSendWatermarks({ .high = 1024 * 1024, .low = 256 * 1024 }, NetSendOverflow::Close);
+			connection.SetReceiveWatermarks({ .high = 256 * 1024, .low = 64 * 1024 });
+		}
+		void OnMessage(NetConnection& connection, const NetReceivedMessage& receivedMessage)
+		{
+			connection.Send(receivedMessage.msg);
+		}
+		// Used instead by event handlers that receive in place
+		void OnMessageView(NetConnection& connection, NetMessageView message)
+		{
+			connection.Send(std::string(message));
+		}
+		void OnDisconnect(NetConnection& connection)
+		{
+			LENET_LOG_INFO(User, "Disconnected: {}", connection.GetId());
+		}
+	};
+
+	class DatagramEchoHandler
+	{
+	public:
+		void OnPeer(NetPeer& peer)
+		{
+			LENET_LOG_INFO(User, "Peer: {}", peer.address.ToString());
+		}
+		void OnDatagram(NetPeer& peer, NetMessageView message)
+		{
+			peer.Send(message);
+		}
+	};
+
+	void DatagramServer()
+	{
+		LENET_LOG_INFO(User, "Datagram Server");
+
+		NetDatagramEndpoint<DatagramEchoHandler> endpoint(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), 3000));
+
+		bool close = false;
+		while (!close)
+		{
+			endpoint.HandleNetEvents(100u);
+			endpoint.RemoveIdlePeers(std::chrono::seconds(60));
+		}
+	}
+
+	template <typename TNetEventManager>
+	void ThreadedServer(size_t threadCount, bool sharded = false)
+	{
+		LENET_LOG_INFO(User, "{} Server ({} threads)", sharded ? "Sharded" : "Threaded", threadCount);
+
+		NetServer<TNetEventManager, EchoHandler> server(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), 3000), EchoHandler());
+
+		for (size_t i = 1; i < threadCount; ++i)
+		{
+			server.AddEventHandler();
+		}
+		if (sharded) { server.StartSharded(); }
+		else { server.StartThreads(); }
+
+		bool close = false;
+		while (!close)
+		{
+			if (sharded) { std::this_thread::sleep_for(std::chrono::milliseconds(100)); }
+			else { server.Accept(); }
+		}
+		server.DisconnectAll();
+	}
+
+#ifdef LE_BUILD_PLATFORM_LINUX
+	template <NetEpollTrigger Trigger = NetEpollTrigger::Level>
+	void EpollServer()
+	{
+		LENET_LOG_INFO(User, "Epoll Server ({})", Trigger == NetEpollTrigger::Edge ? "edge-triggered" : "level-triggered");
+
+		NetServer<NetEpollEventManager<NetProtocolTCP, NetEventHandler, Trigger>> server(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), 3000));
+		server.OnConnection([](NetConnection& connection) {
+			LENET_LOG_INFO(User, "Connect: {}", connection.GetId());
+
+			connection.OnDisconnect([](const NetConnection& connection) { LENET_LOG_INFO(User, "Disconnected: {}", connection.GetId()); });
+
+			connection.OnMessage([](const NetConnection& connection, const NetReceivedMessage& receivedMessage) {
+				LENET_LOG_INFO(User, "From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
 			});
-			TimedTask<3>([&server]() {
-				if (!server.HasConnections()) return;
-				int rndClient = rand() % (server.NumberOfConnections());
-				auto connection = server.GetConnections().begin();
-				std::advance(connection, rndClient);
-				connection->messagesToSend.emplace("Hello from server");
+		});
+
+		// Handlers run as soon as HandleNetEvents has received the messages, no Update() needed
+		server.SetDispatchMode(NetDispatchMode::Inline);
+
+		auto& timers = server.GetTimers();
+		timers.ScheduleRepeating(std::chrono::seconds(3), [&server]() {
+			if (!server.HasConnections()) return;
+			int rndClient = rand() % (server.NumberOfConnections());
+			if (NetConnection* connection = server.GetConnection(rndClient)) connection->Send("Hello from server");
+		});
+
+		bool close = false;
+		while (!close)
+		{
+			server.Accept();
+			server.HandleNetEvents();
+		}
+		server.DisconnectAll();
+	}
+
+	void IoUringServer()
+	{
+		LENET_LOG_INFO(User, "io_uring Server");
+
+		NetServer<NetIoUringEventManager<NetProtocolTCP, NetEventHandler>> server(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), 3000));
+		server.OnConnection([](NetConnection& connection) {
+			LENET_LOG_INFO(User, "Connect: {}", connection.GetId());
+
+			connection.OnDisconnect([](const NetConnection& connection) { LENET_LOG_INFO(User, "Disconnected: {}", connection.GetId()); });
+
+			connection.OnMessage([](const NetConnection& connection, const NetReceivedMessage& receivedMessage) {
+				LENET_LOG_INFO(User, "From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
 			});
+		});
+
+		// Handlers run as soon as HandleNetEvents has received the messages, no Update() needed
+		server.SetDispatchMode(NetDispatchMode::Inline);
+
+		auto& timers = server.GetTimers();
+		timers.ScheduleRepeating(std::chrono::seconds(3), [&server]() {
+			if (!server.HasConnections()) return;
+			int rndClient = rand() % (server.NumberOfConnections());
+			if (NetConnection* connection = server.GetConnection(rndClient)) connection->Send("Hello from server");
+		});
+
+		bool close = false;
+		while (!close)
+		{
+			server.Accept();
+			server.HandleNetEvents();
 		}
 		server.DisconnectAll();
 	}
+#endif
 
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	void IOCPServer()
 	{
-		NetLogger::LogUser("IOCP Server");
+		LENET_LOG_INFO(User, "IOCP Server");
 
 		NetServer<NetIOCPEventManager<NetProtocolTCP, NetEventHandler>> server(NetSocketIPv4Address(NetIPv4Address("0.0.0.0"), 3000));
 		server.OnConnection([](NetConnection& connection) {
-			NetLogger::LogUser("Connect: {}", connection.GetId());
+			LENET_LOG_INFO(User, "Connect: {}", connection.GetId());
 
-			connection.OnDisconnect([](const NetConnection& connection) { NetLogger::LogUser("Disconnected: {}", connection.GetId()); });
+			connection.OnDisconnect([](const NetConnection& connection) { LENET_LOG_INFO(User, "Disconnected: {}", connection.GetId()); });
 
 			connection.OnMessage([](const NetConnection& connection, const NetReceivedMessage& receivedMessage) {
-				NetLogger::LogUser("From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
+				LENET_LOG_INFO(User, "From: {}, msg: {}", connection.GetId(), receivedMessage.msg);
 			});
 		});
 
+		// Handlers run as soon as HandleNetEvents has received the messages, no Update() needed
+		server.SetDispatchMode(NetDispatchMode::Inline);
+
+		auto& timers = server.GetTimers();
+		timers.ScheduleRepeating(std::chrono::seconds(3), [&server]() {
+			if (!server.HasConnections()) return;
+			int rndClient = rand() % (server.NumberOfConnections());
+			if (NetConnection* connection = server.GetConnection(rndClient)) connection->Send("Hello from server");
+			//if (NetConnection* connection = server.GetConnection(rndClient)) connection->Send(largeMessage);
+		});
+
 		bool close = false;
+		//timers.Schedule(std::chrono::seconds(10), [&close]() { close = true; });
 		while (!close)
 		{
 			server.Accept();
 			server.HandleNetEvents();
-			TimedTask<5>([&server]() {
-				NetLogger::LogUser("Update()");
-				server.Update();
-			});
-			TimedTask<3>([&server]() {
-				if (!server.HasConnections()) return;
-				int rndClient = rand() % (server.NumberOfConnections());
-				auto connection = server.GetConnections().begin();
-				std::advance(connection, rndClient);
-				connection->messagesToSend.emplace("Hello from server");
-				//connection->messagesToSend.emplace(largeMessage);
-			});
-
-			//TimedTask<10>([&close]() { close = true; });
 		}
 		server.DisconnectAll();
 	}
+#endif
 }
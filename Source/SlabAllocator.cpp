@@ -0,0 +1,86 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#include "SlabAllocator.hpp"
+
+#ifndef LE_BUILD_PLATFORM_WINDOWS
+	#include <sys/mman.h>
+#endif
+
+namespace LimeEngine::Net
+{
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	void* AllocateSlabRegion(size_t size, bool hugePages)
+	{
+		if (hugePages)
+		{
+			// Large pages need SeLockMemoryPrivilege and are aligned to the large page size
+			size_t largePageSize = GetLargePageMinimum();
+			if (largePageSize != 0 && size % largePageSize == 0)
+			{
+				void* region = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+				if (region != nullptr) return region;
+			}
+			LENET_LOG_INFO(Pool, "[Slab] Large pages are not available, using regular pages");
+		}
+
+		// Reserve twice the size to find an aligned address, then allocate exactly there. Another thread may take the range in between.
+		for (int attempt = 0; attempt < 8; ++attempt)
+		{
+			char* reserved = static_cast<char*>(VirtualAlloc(nullptr, size * 2ull, MEM_RESERVE, PAGE_NOACCESS));
+			if (reserved == nullptr) break;
+			char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(reserved) + size - 1ull) & ~static_cast<uintptr_t>(size - 1ull));
+			VirtualFree(reserved, 0, MEM_RELEASE);
+
+			void* region = VirtualAlloc(aligned, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			if (region != nullptr) return region;
+		}
+		LENET_LAST_ERROR_MSG("Can't allocate slab");
+		return nullptr;
+	}
+
+	void FreeSlabRegion(void* region, size_t size)
+	{
+		VirtualFree(region, 0, MEM_RELEASE);
+	}
+#else
+	void* AllocateSlabRegion(size_t size, bool hugePages)
+	{
+	#ifdef MAP_HUGETLB
+		if (hugePages)
+		{
+			// Explicit huge pages come from the reserved pool (vm.nr_hugepages) and are aligned to the huge page size
+			void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (region != MAP_FAILED)
+			{
+				if ((reinterpret_cast<uintptr_t>(region) & (size - 1ull)) == 0) return region;
+				munmap(region, size);
+			}
+		}
+	#endif
+
+		// Map twice the size and trim the unaligned head and tail
+		char* mapped = static_cast<char*>(mmap(nullptr, size * 2ull, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (mapped == MAP_FAILED)
+		{
+			LENET_LAST_ERROR_MSG("Can't allocate slab");
+			return nullptr;
+		}
+		char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(mapped) + size - 1ull) & ~static_cast<uintptr_t>(size - 1ull));
+		size_t head = static_cast<size_t>(aligned - mapped);
+		if (head != 0) munmap(mapped, head);
+		if (size - head != 0) munmap(aligned + size, size - head);
+
+	#ifdef MADV_HUGEPAGE
+		// Transparent huge pages, the kernel backs the region with huge pages when it can
+		if (hugePages) madvise(aligned, size, MADV_HUGEPAGE);
+	#endif
+		return aligned;
+	}
+
+	void FreeSlabRegion(void* region, size_t size)
+	{
+		munmap(region, size);
+	}
+#endif
+}
@@ -0,0 +1,129 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "NetBase.hpp"
+
+namespace LimeEngine::Net
+{
+	struct SlabOptions
+	{
+		// Number of buffers allocated up front
+		size_t reserveBuffers = 0;
+		// Back slabs with huge pages if the system provides them, falls back to regular pages otherwise
+		bool hugePages = false;
+	};
+
+	// Allocates a region of the given size aligned to its size, which must be a power of two
+	void* AllocateSlabRegion(size_t size, bool hugePages);
+	void FreeSlabRegion(void* region, size_t size);
+
+	// Carves fixed-size, cache-line-aligned buffers out of large SlabSize-aligned regions.
+	// Every slab starts with a header, so a buffer is mapped back to its slab by masking the pointer.
+	template <size_t BufferSize, size_t SlabSize = 2ull * 1024ull * 1024ull>
+	class SlabAllocator
+	{
+		static_assert((SlabSize & (SlabSize - 1)) == 0, "Slab size must be a power of two");
+
+		struct SlabHeader
+		{
+			uint32_t index;
+		};
+
+	public:
+		static constexpr size_t bufferStride = (BufferSize + CacheLineSize - 1) / CacheLineSize * CacheLineSize;
+		static constexpr size_t firstBufferOffset = (sizeof(SlabHeader) + CacheLineSize - 1) / CacheLineSize * CacheLineSize;
+		static constexpr size_t buffersPerSlab = (SlabSize - firstBufferOffset) / bufferStride;
+		static_assert(buffersPerSlab != 0, "Buffer does not fit into a slab");
+
+	public:
+		SlabAllocator(const SlabAllocator&) = delete;
+		SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+		SlabAllocator(SlabAllocator&& other) noexcept : slabs(std::move(other.slabs)), hugePages(other.hugePages) {}
+		SlabAllocator& operator=(SlabAllocator&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Clear();
+				slabs = std::move(other.slabs);
+				hugePages = other.hugePages;
+			}
+			return *this;
+		}
+
+		explicit SlabAllocator(bool hugePages = false) noexcept : hugePages(hugePages) {}
+		~SlabAllocator()
+		{
+			Clear();
+		}
+
+		// Returns the first buffer of a new slab, all buffersPerSlab buffers of the slab follow it with bufferStride step
+		char* AddSlab()
+		{
+			char* slab = CreateSlab(static_cast<uint32_t>(slabs.size()), hugePages);
+			if (slab == nullptr) return nullptr;
+			slabs.push_back(slab);
+			return slab + firstBufferOffset;
+		}
+
+		char* At(size_t index) const noexcept
+		{
+			return slabs[index / buffersPerSlab] + firstBufferOffset + (index % buffersPerSlab) * bufferStride;
+		}
+
+		size_t SlabCount() const noexcept
+		{
+			return slabs.size();
+		}
+		size_t Capacity() const noexcept
+		{
+			return slabs.size() * buffersPerSlab;
+		}
+
+		void Clear() noexcept
+		{
+			for (char* slab : slabs)
+			{
+				DestroySlab(slab);
+			}
+			slabs.clear();
+		}
+
+	public:
+		static char* CreateSlab(uint32_t slabIndex, bool hugePages)
+		{
+			char* slab = static_cast<char*>(AllocateSlabRegion(SlabSize, hugePages));
+			if (slab == nullptr) return nullptr;
+			reinterpret_cast<SlabHeader*>(slab)->index = slabIndex;
+			return slab;
+		}
+		static void DestroySlab(char* slab) noexcept
+		{
+			FreeSlabRegion(slab, SlabSize);
+		}
+
+		// O(1) mapping of a buffer taken from any slab of this layout back to its slab
+		static char* SlabOf(const char* buffer) noexcept
+		{
+			return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(buffer) & ~static_cast<uintptr_t>(SlabSize - 1));
+		}
+		static uint32_t SlabIndexOf(const char* buffer) noexcept
+		{
+			return reinterpret_cast<const SlabHeader*>(SlabOf(buffer))->index;
+		}
+		// Inverse of At()
+		static size_t IndexOf(const char* buffer) noexcept
+		{
+			size_t bufferInSlab = static_cast<size_t>(buffer - SlabOf(buffer) - firstBufferOffset) / bufferStride;
+			return SlabIndexOf(buffer) * buffersPerSlab + bufferInSlab;
+		}
+
+	private:
+		std::vector<char*> slabs;
+		bool hugePages;
+	};
+}
@@ -0,0 +1,278 @@
+// Copyright (C) Pavel Jakushik - All rights reserved
+// See the LICENSE file for copyright and licensing details.
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace LimeEngine::Net
+{
+	// Generational slot map. Values live in fixed pages and never move, so pointers to them stay valid until they are erased.
+	// Live values are tracked in a dense index array: iteration touches only live values and erase is swap-and-pop.
+	// Handles are 64-bit: 32-bit generation, 8-bit map tag and 24-bit slot index. A slot's generation changes on every erase,
+	// so a stale handle is rejected instead of reaching the value that reused its slot.
+	template <typename T>
+	class SlotMap
+	{
+	public:
+		using Handle = uint64_t;
+		static constexpr Handle invalidHandle = 0;
+
+		static constexpr uint32_t indexBits = 24;
+		static constexpr uint32_t maxSlots = 1u << indexBits;
+
+	private:
+		static constexpr size_t pageSize = 256;
+		static constexpr uint32_t freeDenseIndex = std::numeric_limits<uint32_t>::max();
+
+		struct Slot
+		{
+			alignas(T) std::byte storage[sizeof(T)];
+			// Starts at 1 so that no handle equals invalidHandle
+			uint32_t generation = 1;
+			uint32_t denseIndex = freeDenseIndex;
+
+			T& Value() noexcept
+			{
+				return *std::launder(reinterpret_cast<T*>(storage));
+			}
+		};
+
+	public:
+		template <bool IsConst>
+		class Iterator
+		{
+			using Map = std::conditional_t<IsConst, const SlotMap, SlotMap>;
+
+		public:
+			Iterator(Map* slotMap, size_t denseIndex) noexcept : slotMap(slotMap), denseIndex(denseIndex) {}
+
+			auto& operator*() const noexcept
+			{
+				return slotMap->At(denseIndex);
+			}
+			auto* operator->() const noexcept
+			{
+				return &slotMap->At(denseIndex);
+			}
+			Iterator& operator++() noexcept
+			{
+				++denseIndex;
+				return *this;
+			}
+			bool operator==(const Iterator& rhs) const noexcept
+			{
+				return denseIndex == rhs.denseIndex;
+			}
+			bool operator!=(const Iterator& rhs) const noexcept
+			{
+				return denseIndex != rhs.denseIndex;
+			}
+
+		private:
+			Map* slotMap;
+			size_t denseIndex;
+		};
+
+	public:
+		SlotMap(const SlotMap&) = delete;
+		SlotMap& operator=(const SlotMap&) = delete;
+
+		SlotMap(SlotMap&& other) noexcept = default;
+		SlotMap& operator=(SlotMap&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Clear();
+				pages = std::move(other.pages);
+				dense = std::move(other.dense);
+				freeSlots = std::move(other.freeSlots);
+				slotCount = std::exchange(other.slotCount, 0);
+				tag = other.tag;
+			}
+			return *this;
+		}
+
+		// Handles of maps with different tags never match each other
+		explicit SlotMap(uint8_t tag = 0) noexcept : tag(tag) {}
+		~SlotMap()
+		{
+			Clear();
+		}
+
+		// T is constructed with its own handle as the first argument if it accepts one
+		template <typename... TArgs>
+		Handle Emplace(TArgs&&... args)
+		{
+			uint32_t slotIndex;
+			if (!freeSlots.empty())
+			{
+				slotIndex = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else
+			{
+				if (slotCount == maxSlots) return invalidHandle;
+				if (slotCount % pageSize == 0) pages.emplace_back(std::make_unique<Slot[]>(pageSize));
+				slotIndex = slotCount++;
+			}
+
+			Slot& slot = SlotAt(slotIndex);
+			Handle handle = MakeHandle(slotIndex, slot.generation);
+			if constexpr (std::is_constructible_v<T, Handle, TArgs...>) { new (slot.storage) T(handle, std::forward<TArgs>(args)...); }
+			else { new (slot.storage) T(std::forward<TArgs>(args)...); }
+
+			slot.denseIndex = static_cast<uint32_t>(dense.size());
+			dense.push_back(slotIndex);
+			return handle;
+		}
+
+		T* Get(Handle handle) noexcept
+		{
+			Slot* slot = Find(handle);
+			return (slot != nullptr) ? &slot->Value() : nullptr;
+		}
+		const T* Get(Handle handle) const noexcept
+		{
+			return const_cast<SlotMap*>(this)->Get(handle);
+		}
+		bool Contains(Handle handle) const noexcept
+		{
+			return const_cast<SlotMap*>(this)->Find(handle) != nullptr;
+		}
+
+		bool Erase(Handle handle)
+		{
+			Slot* slot = Find(handle);
+			if (slot == nullptr) return false;
+			EraseSlot(SlotIndexOf(handle));
+			return true;
+		}
+		// Erases every value the predicate returns true for, visiting each live value once
+		template <typename TPredicate>
+		size_t EraseIf(TPredicate&& predicate)
+		{
+			size_t erased = 0;
+			for (size_t denseIndex = 0; denseIndex < dense.size();)
+			{
+				if (predicate(At(denseIndex)))
+				{
+					// The last value is moved into this position
+					EraseSlot(dense[denseIndex]);
+					++erased;
+				}
+				else { ++denseIndex; }
+			}
+			return erased;
+		}
+
+		void Clear()
+		{
+			while (!dense.empty())
+			{
+				EraseSlot(dense.back());
+			}
+		}
+
+		// Dense access in O(1), the order changes on erase
+		T& At(size_t denseIndex) noexcept
+		{
+			return SlotAt(dense[denseIndex]).Value();
+		}
+		const T& At(size_t denseIndex) const noexcept
+		{
+			return const_cast<SlotMap*>(this)->At(denseIndex);
+		}
+		Handle HandleAt(size_t denseIndex) const noexcept
+		{
+			uint32_t slotIndex = dense[denseIndex];
+			return MakeHandle(slotIndex, const_cast<SlotMap*>(this)->SlotAt(slotIndex).generation);
+		}
+
+		size_t Size() const noexcept
+		{
+			return dense.size();
+		}
+		bool Empty() const noexcept
+		{
+			return dense.empty();
+		}
+
+		static uint8_t TagOf(Handle handle) noexcept
+		{
+			return static_cast<uint8_t>(handle >> indexBits);
+		}
+
+		Iterator<false> begin() noexcept
+		{
+			return Iterator<false>(this, 0);
+		}
+		Iterator<false> end() noexcept
+		{
+			return Iterator<false>(this, dense.size());
+		}
+		Iterator<true> begin() const noexcept
+		{
+			return Iterator<true>(this, 0);
+		}
+		Iterator<true> end() const noexcept
+		{
+			return Iterator<true>(this, dense.size());
+		}
+
+	private:
+		Handle MakeHandle(uint32_t slotIndex, uint32_t generation) const noexcept
+		{
+			return (static_cast<Handle>(generation) << 32) | (static_cast<Handle>(tag) << indexBits) | slotIndex;
+		}
+		static uint32_t SlotIndexOf(Handle handle) noexcept
+		{
+			return static_cast<uint32_t>(handle) & (maxSlots - 1u);
+		}
+
+		Slot& SlotAt(uint32_t slotIndex) noexcept
+		{
+			return pages[slotIndex / pageSize][slotIndex % pageSize];
+		}
+
+		Slot* Find(Handle handle) noexcept
+		{
+			uint32_t slotIndex = SlotIndexOf(handle);
+			if (TagOf(handle) != tag || slotIndex >= slotCount) return nullptr;
+
+			Slot& slot = SlotAt(slotIndex);
+			if (slot.denseIndex == freeDenseIndex || slot.generation != static_cast<uint32_t>(handle >> 32)) return nullptr;
+			return &slot;
+		}
+
+		void EraseSlot(uint32_t slotIndex)
+		{
+			Slot& slot = SlotAt(slotIndex);
+
+			// Unlinked before the destructor runs, so the value can't be found while it is being destroyed
+			uint32_t lastSlotIndex = dense.back();
+			dense[slot.denseIndex] = lastSlotIndex;
+			SlotAt(lastSlotIndex).denseIndex = slot.denseIndex;
+			dense.pop_back();
+			slot.denseIndex = freeDenseIndex;
+
+			slot.Value().~T();
+
+			// A slot whose generation would wrap around is retired for good
+			if (++slot.generation != 0) { freeSlots.push_back(slotIndex); }
+		}
+
+	private:
+		std::vector<std::unique_ptr<Slot[]>> pages;
+		std::vector<uint32_t> dense;
+		std::vector<uint32_t> freeSlots;
+		uint32_t slotCount = 0;
+		uint8_t tag = 0;
+	};
+}
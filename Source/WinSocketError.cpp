@@ -2,10 +2,13 @@
 // See the LICENSE file for copyright and licensing details.
 
 #include "WinSocketError.hpp"
-#include <WinSock2.h>
+#include "PlatformDetection.hpp"
 
-#define MACRO_TO_STR_CASE(macro) \
-	case macro: return #macro;
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	#include <WinSock2.h>
+
+	#define MACRO_TO_STR_CASE(macro) \
+		case macro: return #macro;
 
 std::string GetWinSocketErrorCodeName(int err)
 {
@@ -109,3 +112,4 @@ std::string GetWinSocketErrorCodeName(int err)
 		default: return "Unknown error code";
 	}
 }
+#endif
@@ -2,8 +2,13 @@
 // See the LICENSE file for copyright and licensing details.
 
 #include "Servers.hpp"
+#include <algorithm>
+#include <clocale>
+#include <memory>
 
-#pragma comment(lib, "Ws2_32.lib")
+#ifdef LE_BUILD_PLATFORM_WINDOWS
+	#pragma comment(lib, "Ws2_32.lib")
+#endif
 
 char* getCmdOption(char** begin, char** end, const std::string& option)
 {
@@ -28,12 +33,33 @@ int main(int argc, char* argv[])
 	// Number of clients
 	int clientCount = 1;
 
-	// Server type PollServer(1) or SelectServer(2) or IOCPServer(3)
+	// Number of event loop threads, 0 - handle events on the main thread
+	int threadCount = 0;
+
+	// Every event loop thread listens on its own SO_REUSEPORT socket
+	bool sharded = false;
+
+	// Length-prefixed messages (NetProtocolFramedTCP) instead of NUL-terminated ones
+	bool framed = false;
+
+	// Framed messages received in place into a per-connection ring (NetRingEventHandler)
+	bool zeroCopy = false;
+
+	// Log records are written by a background thread (NetAsyncLogger), to stdout unless a file is given
+	bool asyncLog = true;
+	LimeEngine::Net::NetAsyncLogOptions logOptions;
+
+	// Server type PollServer(1) or SelectServer(2) or IOCPServer(3) or EpollServer(4) or EdgeTriggeredEpollServer(5) or IoUringServer(6)
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	int serverTypeOption = 3;
+#else
+	int serverTypeOption = 4;
+#endif
 
 	/////////////////////////////
 
 	setlocale(LC_ALL, "Russian");
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	WSADATA wsData;
 	if (WSAStartup(MAKEWORD(2, 2), &wsData) != NO_ERROR)
 	{
@@ -42,6 +68,7 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 	else { std::cout << "WinSock initialization is OK" << std::endl; }
+#endif
 
 	if (cmdOptionExists(argv, argv + argc, "-s") || cmdOptionExists(argv, argv + argc, "--server")) { option = 1; }
 	else if (cmdOptionExists(argv, argv + argc, "-c"))
@@ -72,6 +99,48 @@ int main(int argc, char* argv[])
 	if (cmdOptionExists(argv, argv + argc, "--poll")) { serverTypeOption = 1; }
 	else if (cmdOptionExists(argv, argv + argc, "--select")) { serverTypeOption = 2; }
 	else if (cmdOptionExists(argv, argv + argc, "--iocp")) { serverTypeOption = 3; }
+	else if (cmdOptionExists(argv, argv + argc, "--epoll")) { serverTypeOption = 4; }
+	else if (cmdOptionExists(argv, argv + argc, "--epoll-et")) { serverTypeOption = 5; }
+	else if (cmdOptionExists(argv, argv + argc, "--io-uring")) { serverTypeOption = 6; }
+	else if (cmdOptionExists(argv, argv + argc, "--udp")) { serverTypeOption = 7; }
+
+	if (cmdOptionExists(argv, argv + argc, "--threads"))
+	{
+		char* threadCountStr = getCmdOption(argv, argv + argc, "--threads");
+		threadCount = threadCountStr != nullptr ? std::stoi(threadCountStr) : static_cast<int>(std::thread::hardware_concurrency());
+		if (threadCount < 1) threadCount = 1;
+	}
+	if (cmdOptionExists(argv, argv + argc, "--sharded"))
+	{
+		sharded = true;
+		if (threadCount == 0) threadCount = static_cast<int>(std::thread::hardware_concurrency());
+	}
+
+	if (cmdOptionExists(argv, argv + argc, "--zero-copy")) { zeroCopy = true; }
+	if (zeroCopy || cmdOptionExists(argv, argv + argc, "--framed"))
+	{
+		framed = true;
+		if (threadCount == 0) threadCount = 1;
+	}
+
+	if (cmdOptionExists(argv, argv + argc, "--sync-log")) { asyncLog = false; }
+	if (cmdOptionExists(argv, argv + argc, "--log-block")) { logOptions.overflow = LimeEngine::Net::NetLogOverflow::Block; }
+	if (char* logFile = getCmdOption(argv, argv + argc, "--log-file"); logFile != nullptr) { logOptions.filePath = logFile; }
+	if (asyncLog) LimeEngine::Net::NetAsyncLogger::Start(logOptions);
+	// Runtime threshold 0 trace, 1 debug, 2 info, 3 error, 4 off, levels below LENET_LOG_LEVEL are not compiled in
+	if (char* logLevel = getCmdOption(argv, argv + argc, "--log-level"); logLevel != nullptr)
+	{
+		LimeEngine::Net::NetLogger::SetLevel(static_cast<LimeEngine::Net::NetLogLevel>(std::clamp(std::stoi(logLevel), 0, 4)));
+	}
+
+	// Plain-text metrics dump on 127.0.0.1:<port>
+	std::unique_ptr<LimeEngine::Net::NetMetricsAdmin> metricsAdmin;
+	if (char* metricsPort = getCmdOption(argv, argv + argc, "--metrics-port"); metricsPort != nullptr)
+	{
+		metricsAdmin = std::make_unique<LimeEngine::Net::NetMetricsAdmin>(
+			LimeEngine::Net::NetSocketIPv4Address(LimeEngine::Net::NetIPv4Address("127.0.0.1"), static_cast<uint16_t>(std::stoi(metricsPort))));
+		metricsAdmin->Start();
+	}
 
 	//    char* filename = getCmdOption(argv, argv + argc, "-f");
 	//    if (filename)
@@ -87,28 +156,81 @@ int main(int argc, char* argv[])
 			std::cin >> option;
 		}
 
-		if (option == 1)
+		if (option == 1 && zeroCopy)
+		{
+#ifdef LE_BUILD_PLATFORM_LINUX
+			LimeEngine::Net::EchoServer::ThreadedServer<
+				LimeEngine::Net::NetEpollEventManager<LimeEngine::Net::NetProtocolFramedTCP, LimeEngine::Net::NetRingEventHandler>>(threadCount, sharded);
+#else
+			LimeEngine::Net::EchoServer::ThreadedServer<
+				LimeEngine::Net::NetPollEventManager<LimeEngine::Net::NetProtocolFramedTCP, LimeEngine::Net::NetRingEventHandler>>(threadCount, sharded);
+#endif
+			break;
+		}
+		else if (option == 1 && framed)
+		{
+#ifdef LE_BUILD_PLATFORM_LINUX
+			LimeEngine::Net::EchoServer::ThreadedServer<
+				LimeEngine::Net::NetEpollEventManager<LimeEngine::Net::NetProtocolFramedTCP, LimeEngine::Net::NetFramedEventHandler>>(threadCount, sharded);
+#else
+			LimeEngine::Net::EchoServer::ThreadedServer<
+				LimeEngine::Net::NetPollEventManager<LimeEngine::Net::NetProtocolFramedTCP, LimeEngine::Net::NetFramedEventHandler>>(threadCount, sharded);
+#endif
+			break;
+		}
+		else if (option == 1 && threadCount > 0)
+		{
+#ifdef LE_BUILD_PLATFORM_LINUX
+			LimeEngine::Net::EchoServer::ThreadedServer<LimeEngine::Net::NetEpollEventManager<LimeEngine::Net::NetProtocolTCP>>(threadCount, sharded);
+#else
+			LimeEngine::Net::EchoServer::ThreadedServer<LimeEngine::Net::NetPollEventManager<LimeEngine::Net::NetProtocolTCP>>(threadCount, sharded);
+#endif
+			break;
+		}
+		else if (option == 1)
 		{
 			switch (serverTypeOption)
 			{
 				case 1: LimeEngine::Net::EchoServer::PollServer(); break;
 				case 2: LimeEngine::Net::EchoServer::SelectServer(); break;
+				case 7: LimeEngine::Net::EchoServer::DatagramServer(); break;
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 				case 3: LimeEngine::Net::EchoServer::IOCPServer(); break;
 
 				default: LimeEngine::Net::EchoServer::IOCPServer(); break;
+#endif
+#ifdef LE_BUILD_PLATFORM_LINUX
+				case 4: LimeEngine::Net::EchoServer::EpollServer(); break;
+				case 5: LimeEngine::Net::EchoServer::EpollServer<LimeEngine::Net::NetEpollTrigger::Edge>(); break;
+				case 6: LimeEngine::Net::EchoServer::IoUringServer(); break;
+
+				default: LimeEngine::Net::EchoServer::EpollServer(); break;
+#endif
 			}
 			break;
 		}
 		else if (option == 2)
 		{
 			std::cout << "Run " << clientCount << " Clients" << std::endl;
-			LimeEngine::Net::EchoServer::Client(clientCount);
+			if (framed) { LimeEngine::Net::EchoServer::FramedClient(clientCount); }
+			else { LimeEngine::Net::EchoServer::Client(clientCount); }
 			break;
 		}
 		else if (option == 0) { break; }
 	}
 
+	metricsAdmin.reset();
+
+#ifdef LE_BUILD_PLATFORM_WINDOWS
 	WSACleanup();
+#endif
+
+	if (LimeEngine::Net::NetAsyncLogger::IsRunning())
+	{
+		auto logStats = LimeEngine::Net::NetAsyncLogger::Stats();
+		LimeEngine::Net::NetAsyncLogger::Stop();
+		std::cout << "Log records written: " << logStats.written << ", dropped: " << logStats.dropped << ", blocked: " << logStats.blocked << std::endl;
+	}
 
 	std::cout << "Exit" << std::endl;
 	std::cout << "Press any button..." << std::endl;